@@ -5,7 +5,9 @@
 
 #include <complex>
 #include <mutex>
+#include <span>
 #include <string>
+#include <vector>
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -20,6 +22,11 @@ std::mutex                                  mtx;
 utils::sliding_buffer<std::complex<float>>  slidingPlot(512);
 utils::sliding_buffer<uint8_t>              slidingText(50);
 size_t                                      payloadPos = 0;
+// The frame buffers, reused: no allocations per frame once they have grown
+std::vector<uint8_t>                        frameInput;
+std::vector<std::complex<double>>           frameTx;
+std::vector<std::complex<double>>           frameSymbols;
+std::vector<uint8_t>                        frameBytes;
 const std::string                           payload =
     "Hello, world! "
     "I am a Software-Defined Radio Stack.          "
@@ -200,27 +207,28 @@ bool OFDMDemoWindow::eventFilter(QObject* obj, QEvent* event)
 
 void OFDMDemoWindow::updateFrame()
 {
-    std::vector<uint8_t> input;
+    auto& input = frameInput;
+    input.clear();
     for (int i = 0; i < 4; ++i)
     {
         input.push_back(payload[payloadPos % payload.size()]);
         ++payloadPos;
     }
 
-    auto const_syms = modulation::to_constl<modulation::e16QAM>(input); // bits encoding
-    if (const_syms.empty()) return;
+    auto& tx = frameTx;
+    if (input.empty() || !ofdm::tx<modulation::e16QAM>(input, 8, tx)) // bits encoding and multiplexing in one pass
+        return;
 
-    auto tx_exp = ofdm::tx(const_syms, 8); // multiplexing
-    if (!tx_exp) return;
-
-    auto& tx = *tx_exp;
-
-    ofdm::rx(tx, 8) // demultiplexing
-        .transform([](auto&& rx)
+    auto& const_syms = frameSymbols;
+    frameBytes.resize(input.size());
+    ofdm::rx(tx, 8, const_syms) // demultiplexing
+        .and_then([&const_syms]()
+        {
+            return modulation::from_constl<modulation::e16QAM>(const_syms, std::span(frameBytes)); // bits decoding
+        })
+        .transform([](size_t count)
         {
-            auto bytes = modulation::from_constl<modulation::e16QAM>(rx); // bits decoding
-            slidingText.push_back(bytes.begin(), bytes.end());
-            return std::expected<void, std::string>{};
+            slidingText.push_back(frameBytes.begin(), frameBytes.begin() + count);
         });
 
     // time domain
@@ -0,0 +1,82 @@
+#include "fft.hpp"
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+// Compares the algorithms of the power of 2 sizes, all executed out of place as ofdm::tx/rx do: src -> dst,
+// src left intact. The in-place Cooley-Tukey (bit reversal + butterflies) is the reference for
+// - the out-of-place Stockham autosort, per instruction set;
+// - the four-step algorithm, with the widest instruction set.
+// Prints the time per transform in nanoseconds.
+
+namespace
+{
+    template <typename F>
+    double measure(size_t size, F&& fn)
+    {
+        using clock = std::chrono::steady_clock;
+        const size_t runs = std::max<size_t>(8, (size_t{1} << 24) / size);
+        fn(); // Warming up the caches and the plan's scratch
+        const auto start = clock::now();
+        for (size_t r = 0; r < runs; ++r)
+            fn();
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count() / runs;
+    }
+
+    template <typename T>
+    const char* name(typename fft::plan<T>::algorithm kind)
+    {
+        using algorithm = typename fft::plan<T>::algorithm;
+        switch (kind)
+        {
+        case algorithm::radix2:      return "cooley-tukey";
+        case algorithm::stockham:    return "stockham";
+        case algorithm::four_step:   return "four-step";
+        case algorithm::mixed_radix: return "mixed-radix";
+        case algorithm::bluestein:   return "bluestein";
+        }
+        return "";
+    }
+
+    template <typename T>
+    void compare(simd::isa set, typename fft::plan<T>::algorithm first, typename fft::plan<T>::algorithm second, size_t from, size_t to)
+    {
+        using plan = fft::plan<T>;
+        std::printf("%-6s %-6s %10s %14s %14s %8s\n", simd::name(set).data(), sizeof(T) == 4 ? "float" : "double",
+                    "size", name<T>(first), name<T>(second), "ratio");
+        for (size_t size = from; size <= to; size *= 4)
+        {
+            auto a = plan::create(size, fft::direction::forward, set, first);
+            auto b = plan::create(size, fft::direction::forward, set, second);
+            if (!a || !b)
+                return;
+
+            std::vector<std::complex<T>> src(size), dst(size);
+            for (size_t n = 0; n < size; ++n)
+                src[n] = { static_cast<T>(n % 7), static_cast<T>(n % 5) };
+
+            const double ta = measure(size, [&]() { (void)a->execute(src.begin(), src.end(), dst.begin()); });
+            const double tb = measure(size, [&]() { (void)b->execute(src.begin(), src.end(), dst.begin()); });
+            std::printf("%-13s %10zu %14.0f %14.0f %8.2f\n", "", size, ta, tb, ta / tb);
+        }
+    }
+}
+
+int main()
+{
+    for (auto set: {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+    {
+        if (!simd::supported(set))
+            continue;
+        compare<float>(set, fft::plan<float>::algorithm::radix2, fft::plan<float>::algorithm::stockham, 64, size_t{1} << 22);
+        compare<double>(set, fft::plan<double>::algorithm::radix2, fft::plan<double>::algorithm::stockham, 64, size_t{1} << 22);
+    }
+
+    // The four-step algorithm on all the threads of the parallel backend
+    std::printf("four-step on %zu threads\n", parallel::concurrency());
+    compare<float>(simd::detect(), fft::plan<float>::algorithm::radix2, fft::plan<float>::algorithm::four_step, size_t{1} << 12, size_t{1} << 24);
+    compare<double>(simd::detect(), fft::plan<double>::algorithm::radix2, fft::plan<double>::algorithm::four_step, size_t{1} << 12, size_t{1} << 24);
+    return 0;
+}
\ No newline at end of file
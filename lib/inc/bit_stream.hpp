@@ -0,0 +1,105 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace utils
+{
+    namespace detail
+    {
+        // The 8 bytes at p as a big-endian word: the first byte in the most significant bits
+        inline uint64_t load_be64(const uint8_t* p) noexcept
+        {
+            uint64_t w;
+            std::memcpy(&w, p, sizeof(w));
+            if constexpr (std::endian::native == std::endian::little)
+                w = std::byteswap(w);
+            return w;
+        }
+
+        inline void store_be32(uint8_t* p, uint32_t v) noexcept
+        {
+            if constexpr (std::endian::native == std::endian::little)
+                v = std::byteswap(v);
+            std::memcpy(p, &v, sizeof(v));
+        }
+    }
+
+    /**
+     * Pulls the chunks of 1 to 32 bits out of the packed bytes, the most significant bits first, e.g. the symbols of
+     * any modulation order, straddling the byte boundaries or not. The bits are buffered in a 64-bit word refilled
+     * with whole bytes by a single load while 8 bytes remain. Reads past the end give zero bits.
+     */
+    class bit_reader
+    {
+    public:
+        explicit bit_reader(std::span<const uint8_t> in) noexcept
+            : in_(in) {}
+
+        uint32_t read(size_t bits) noexcept
+        {
+            if (have_ < bits)
+                refill();
+            have_ -= bits;
+            return static_cast<uint32_t>(word_ >> have_) & static_cast<uint32_t>((uint64_t{1} << bits) - 1);
+        }
+
+    private:
+        void refill() noexcept
+        {
+            const size_t bytes = (63 - have_) / 8; // at least 4, at most 7: no shift by the full width
+            if (pos_ + sizeof(uint64_t) <= in_.size())
+                word_ = (word_ << (8 * bytes)) | (detail::load_be64(in_.data() + pos_) >> (64 - 8 * bytes));
+            else
+                for (size_t i = 0; i < bytes; ++i)
+                    word_ = (word_ << 8) | (pos_ + i < in_.size() ? in_[pos_ + i] : 0);
+            pos_ += bytes;
+            have_ += 8 * bytes;
+        }
+
+        std::span<const uint8_t>    in_;
+        size_t                      pos_ = 0;
+        uint64_t                    word_ = 0;  // the low have_ bits are the next ones
+        size_t                      have_ = 0;
+    };
+
+    /**
+     * Pushes the chunks of 1 to 32 bits into the packed bytes, the most significant bits first, through a 64-bit word
+     * emptied 4 bytes at a time. flush() writes out the remaining whole bytes; the bits short of a byte, i.e. the padding
+     * of the last symbol, are dropped.
+     */
+    class bit_writer
+    {
+    public:
+        explicit bit_writer(uint8_t* out) noexcept
+            : out_(out) {}
+
+        void write(uint32_t chunk, size_t bits) noexcept
+        {
+            word_ = (word_ << bits) | chunk;
+            have_ += bits;
+            if (have_ >= 32)
+            {
+                have_ -= 32;
+                detail::store_be32(out_, static_cast<uint32_t>(word_ >> have_));
+                out_ += 4;
+            }
+        }
+
+        // Returns the end of the written bytes
+        uint8_t* flush() noexcept
+        {
+            for (; have_ >= 8; have_ -= 8)
+                *out_++ = static_cast<uint8_t>(word_ >> (have_ - 8));
+            have_ = 0;
+            return out_;
+        }
+
+    private:
+        uint8_t*                    out_;
+        uint64_t                    word_ = 0;  // the low have_ bits are pending
+        size_t                      have_ = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,346 @@
+#pragma once
+
+#include "fft.hpp"
+#include "modulation.hpp"
+#include "ofdm.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <concepts>
+#include <expected>
+#include <format>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace sim
+{
+    /**
+     * @brief The Philox4x32-10 counter-based generator of Salmon et al.: the 4 words of a block are a bijection of
+     * its 128-bit counter under the 64-bit key, so any block of any stream is computed directly, without a state
+     * passed from one block to the next. The blocks are laid out a lane each and the rounds run over the lanes,
+     * which the compiler turns into the vector 32-bit multiplies.
+     *
+     * @param counter The counter of the first block, incremented in its lowest 64 bits for the next ones.
+     * @param key The key.
+     * @param out The words of the blocks, 4 a block.
+     * @param blocks The number of the blocks.
+     */
+    inline void philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key, uint32_t* out, size_t blocks) noexcept
+    {
+        constexpr size_t lanes = 16;
+        const uint64_t first = counter[0] | uint64_t{counter[1]} << 32;
+        for (size_t b = 0; b < blocks; b += lanes)
+        {
+            uint32_t c0[lanes], c1[lanes], c2[lanes], c3[lanes];
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                const uint64_t n = first + b + l;
+                c0[l] = static_cast<uint32_t>(n);
+                c1[l] = static_cast<uint32_t>(n >> 32);
+                c2[l] = counter[2];
+                c3[l] = counter[3];
+            }
+            uint32_t k0 = key[0], k1 = key[1];
+            for (int round = 0; round < 10; ++round)
+            {
+                for (size_t l = 0; l < lanes; ++l)
+                {
+                    const uint64_t p0 = uint64_t{0xD2511F53} * c0[l];
+                    const uint64_t p1 = uint64_t{0xCD9E8D57} * c2[l];
+                    const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+                    const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+                    c1[l] = static_cast<uint32_t>(p1);
+                    c3[l] = static_cast<uint32_t>(p0);
+                    c0[l] = n0;
+                    c2[l] = n2;
+                }
+                k0 += 0x9E3779B9;
+                k1 += 0xBB67AE85;
+            }
+            for (size_t l = 0; l < lanes && b + l < blocks; ++l)
+            {
+                out[4 * (b + l)]     = c0[l];
+                out[4 * (b + l) + 1] = c1[l];
+                out[4 * (b + l) + 2] = c2[l];
+                out[4 * (b + l) + 3] = c3[l];
+            }
+        }
+    }
+
+    /**
+     * A stream of the random numbers of Philox4x32-10 keyed by the seed, the stream index making the upper half
+     * of the counter: the streams of the same seed never overlap, and a stream is the same on any thread and any machine.
+     */
+    class philox_stream
+    {
+    public:
+        philox_stream(uint64_t seed, uint64_t stream) noexcept
+            : key_{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) }
+            , stream_{ static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32) } {}
+
+        // The next words of the stream; the words of the last block left over are skipped
+        void fill(std::span<uint32_t> out)
+        {
+            constexpr size_t chunk = 256;
+            uint32_t words[4 * chunk];
+            for (size_t i = 0; i < out.size(); i += 4 * chunk)
+            {
+                const size_t n = std::min(out.size() - i, 4 * chunk);
+                const size_t blocks = (n + 3) / 4;
+                philox4x32(counter(), key_, words, blocks);
+                position_ += blocks;
+                std::copy_n(words, n, out.begin() + i);
+            }
+        }
+
+        void bytes(std::span<uint8_t> out)
+        {
+            std::vector<uint32_t> words((out.size() + 3) / 4);
+            fill(words);
+            for (size_t i = 0; i < out.size(); ++i)
+                out[i] = static_cast<uint8_t>(words[i / 4] >> (8 * (i % 4)));
+        }
+
+        /**
+         * @brief The next circularly-symmetric complex Gaussian numbers of the Box-Muller transform, 2 a block.
+         * @param variance E|z|^2, the half of it in each of the parts.
+         */
+        template <std::floating_point T>
+        void gaussian(std::span<std::complex<T>> out, double variance)
+        {
+            std::vector<uint32_t> words(2 * out.size());
+            fill(words);
+            const double sigma = std::sqrt(variance / 2);
+            for (size_t i = 0; i < out.size(); ++i)
+            {
+                const double u = (words[2 * i] + 1.0) * 0x1p-32; // in (0, 1], no log of 0
+                const double v = words[2 * i + 1] * 0x1p-32;
+                const double r = sigma * std::sqrt(-2 * std::log(u));
+                out[i] = { static_cast<T>(r * std::cos(2 * std::numbers::pi * v)), static_cast<T>(r * std::sin(2 * std::numbers::pi * v)) };
+            }
+        }
+
+    private:
+        std::array<uint32_t, 4> counter() const noexcept
+        {
+            return { static_cast<uint32_t>(position_), static_cast<uint32_t>(position_ >> 32), stream_[0], stream_[1] };
+        }
+
+        std::array<uint32_t, 2> key_;
+        std::array<uint32_t, 2> stream_;
+        uint64_t                position_ = 0;  // the next block
+    };
+
+    /**
+     * The impairments of a channel
+     */
+    struct impairments
+    {
+        std::vector<std::complex<double>>   taps{ 1 };          // the multipath impulse response
+        double                              cfo = 0;            // the carrier frequency offset in cycles per sample
+        double                              phase_noise = 0;    // the standard deviation of the Wiener phase step per sample, radians
+        double                              noise_variance = 0; // the AWGN E|n|^2 per sample
+    };
+
+    /**
+     * The channel simulator of a burst: the multipath FIR starting from the silence, then the rotation by the CFO and
+     * the Wiener phase noise, then the AWGN, all the randomness drawn from a philox_stream.
+     */
+    template <std::floating_point T>
+    class channel
+    {
+    public:
+        static std::expected<channel, std::string> create(const impairments& config)
+        {
+            if (config.taps.empty())
+                return std::unexpected("The channel has no taps");
+            if (!(config.noise_variance >= 0 && config.phase_noise >= 0))
+                return std::unexpected(std::format("The noise variance={} and the phase noise={} must not be negative", config.noise_variance, config.phase_noise));
+            return channel(config);
+        }
+
+        /**
+         * @brief Passes the burst through the channel.
+         *
+         * @param in The transmitted samples.
+         * @param out The received samples, as many.
+         * @param random The source of the noise.
+         */
+        std::expected<void, std::string> apply(std::span<const std::complex<T>> in, std::span<std::complex<T>> out, philox_stream& random)
+        {
+            if (in.size() != out.size())
+                return std::unexpected(std::format("The output size={} differs from the input size={}", out.size(), in.size()));
+
+            const auto& taps = config_.taps;
+            for (size_t n = in.size(); n-- > 0;) // backwards, so that out may alias in
+            {
+                std::complex<double> acc = 0;
+                for (size_t t = 0; t < taps.size() && t <= n; ++t)
+                    acc += taps[t] * std::complex<double>(in[n - t]);
+                out[n] = std::complex<T>(acc);
+            }
+
+            if (config_.cfo != 0 || config_.phase_noise > 0)
+            {
+                steps_.resize(in.size());
+                if (config_.phase_noise > 0)
+                    random.gaussian(std::span(steps_), 2 * config_.phase_noise * config_.phase_noise);
+                double phase = 0;
+                for (size_t n = 0; n < out.size(); ++n)
+                {
+                    out[n] *= std::polar(T{1}, static_cast<T>(phase));
+                    phase = std::remainder(phase + 2 * std::numbers::pi * config_.cfo + (config_.phase_noise > 0 ? steps_[n].real() : 0.0), 2 * std::numbers::pi);
+                }
+            }
+
+            if (config_.noise_variance > 0)
+            {
+                noise_.resize(in.size());
+                random.gaussian(std::span(noise_), config_.noise_variance);
+                for (size_t n = 0; n < out.size(); ++n)
+                    out[n] += noise_[n];
+            }
+            return {};
+        }
+
+        const impairments& config() const noexcept { return config_; }
+
+    private:
+        explicit channel(const impairments& config)
+            : config_(config) {}
+
+        impairments                     config_;
+        std::vector<std::complex<double>> steps_;
+        std::vector<std::complex<T>>    noise_;
+    };
+
+    /**
+     * A point of the BER curve
+     */
+    struct ber_point
+    {
+        double      snr_db;     // Es/N0 per subcarrier
+        uint64_t    bits = 0;
+        uint64_t    errors = 0;
+
+        double ber() const noexcept { return bits ? static_cast<double>(errors) / bits : 0.0; }
+    };
+
+    /**
+     * The configuration of a BER sweep of the OFDM link
+     */
+    struct sweep_config
+    {
+        std::vector<double> snr_db;             // Es/N0 per subcarrier of the points
+        size_t              frames = 100;       // the trials of a point
+        size_t              symbols = 8;        // the OFDM symbols of a frame
+        size_t              size = 64;          // the subcarriers of a symbol
+        size_t              cp_size = 16;
+        impairments         channel;            // the noise variance is set by the points
+        uint64_t            seed = 0;
+    };
+
+    /**
+     * @brief Measures the BER of the OFDM link over the channel at every SNR: random frames through ofdm::modulator,
+     * the channel, ofdm::demodulator, the zero forcing of the known multipath and the hard decisions. The trials of all
+     * the points are split across the cores; the trial f of the point p draws everything from the philox stream
+     * p * frames + f of the seed, so the counts do not depend on the number of the threads nor on their schedule.
+     *
+     * @return std::expected<std::vector<ber_point>, std::string>
+     * - The points on success;
+     * - Error string on failure.
+     */
+    template <modulation::constellation Mod, std::floating_point T = float>
+    std::expected<std::vector<ber_point>, std::string> ber_sweep(const sweep_config& config)
+    {
+        const size_t N = config.size;
+        const size_t bits = config.symbols * N * Mod::bits_per_symbol;
+        if (N == 0 || config.symbols == 0 || bits % 8 != 0)
+            return std::unexpected(std::format("The frame of {} symbols of {} subcarriers is not a whole number of bytes", config.symbols, N));
+        if (config.channel.taps.size() > config.cp_size + 1)
+            return std::unexpected(std::format("The multipath of {} taps exceeds the cyclic prefix size={}", config.channel.taps.size(), config.cp_size));
+
+        // The channel frequency response, the same for all the trials
+        std::vector<std::complex<T>> response(N);
+        for (size_t t = 0; t < config.channel.taps.size(); ++t)
+            response[t % N] += std::complex<T>(config.channel.taps[t]);
+        auto plan = fft::plan<T>::create(N, fft::direction::forward);
+        if (!plan)
+            return std::unexpected(plan.error());
+        if (auto r = plan->execute(response.begin(), response.end()); !r)
+            return std::unexpected(r.error());
+        for (auto& h: response)
+            h = std::norm(h) > 0 ? T{1} / h : std::complex<T>{};
+
+        std::vector<ber_point> points;
+        for (double snr: config.snr_db)
+            points.push_back({ snr });
+        std::vector<std::atomic<uint64_t>> errors(points.size());
+        std::atomic<bool> failed = false;
+
+        parallel::for_range(points.size() * config.frames, 1, [&](size_t begin, size_t end)
+        {
+            auto mod = ofdm::modulator<T>::create(N, config.cp_size);
+            auto demod = ofdm::demodulator<T>::create(N, config.cp_size);
+            if (!mod || !demod)
+            {
+                failed = true;
+                return;
+            }
+            std::vector<uint8_t> sent(bits / 8), received;
+            std::vector<std::complex<T>> samples;
+            for (size_t task = begin; task < end; ++task)
+            {
+                const size_t p = task / config.frames;
+                auto link = config.channel;
+                link.noise_variance = 1 / (N * std::pow(10.0, config.snr_db[p] / 10)); // the FFT gains N per bin
+                auto ch = channel<T>::create(link);
+                philox_stream random(config.seed, task);
+                random.bytes(sent);
+
+                const auto frame = mod->template transmit<Mod>(sent);
+                if (!ch || !frame)
+                {
+                    failed = true;
+                    return;
+                }
+                samples.assign(frame->begin(), frame->end());
+                const auto subcarriers = ch->apply(samples, samples, random)
+                    .and_then([&demod, &samples]()
+                    {
+                        return demod->process(samples);
+                    });
+                if (!subcarriers)
+                {
+                    failed = true;
+                    return;
+                }
+                samples.assign(subcarriers->begin(), subcarriers->end());
+                for (size_t i = 0; i < samples.size(); ++i)
+                    samples[i] *= response[i % N];
+                received = modulation::from_constl<Mod, T>(samples);
+
+                uint64_t wrong = 0;
+                for (size_t i = 0; i < sent.size(); ++i)
+                    wrong += std::popcount(static_cast<uint8_t>(sent[i] ^ received[i]));
+                errors[p].fetch_add(wrong, std::memory_order_relaxed);
+            }
+        });
+        if (failed)
+            return std::unexpected("A trial of the sweep failed");
+
+        for (size_t p = 0; p < points.size(); ++p)
+        {
+            points[p].bits = config.frames * bits;
+            points[p].errors = errors[p];
+        }
+        return points;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "fft_kernels.hpp"
+#include "simd.hpp"
+#include "subcarrier_map.hpp"
+#include <atomic>
+#include <complex>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ofdm
+{
+    /**
+     * The channel estimator of the pilots: the least squares estimates at the pilots, interpolated linearly across
+     * the data subcarriers and averaged across the symbols. The interpolation runs over the pilots next to a subcarrier
+     * in frequency, extrapolating the edge pair beyond the outer pilots to follow the phase slope of a timing offset;
+     * its pilot pairs and weights are precomputed once, so an update is two straight loops.
+     */
+    template <std::floating_point T>
+    class channel_estimator
+    {
+    public:
+        /**
+         * @brief Creates the estimator.
+         *
+         * @param map The allocation of the subcarriers, at least one pilot.
+         * @param smoothing The weight of the newest symbol in the estimate: 1 follows every symbol alone,
+         * less averages a slowly varying channel over the symbols.
+         * @return std::expected<channel_estimator, std::string>
+         * - The estimator on success;
+         * - Error string on failure.
+         */
+        static std::expected<channel_estimator, std::string> create(const subcarrier_map& map, T smoothing = 1)
+        {
+            if (map.pilot_size() == 0)
+                return std::unexpected("The allocation has no pilots");
+            if (!(smoothing > 0 && smoothing <= 1))
+                return std::unexpected(std::format("The smoothing={} is out of (0, 1]", smoothing));
+
+            channel_estimator e(map, smoothing);
+            const size_t N = map.size();
+            const auto pilots = map.pilot_bins();
+            const auto frequency = [N](uint32_t bin)
+            {
+                return static_cast<T>((bin + N / 2) % N); // the FFT order to the centred order
+            };
+            for (const auto bin: map.data_bins())
+            {
+                const T f = frequency(bin);
+                size_t j = 0; // the pair j, j + 1 around f, the edge pair beyond the outer pilots
+                while (j + 2 < pilots.size() && frequency(pilots[j + 1]) < f)
+                    ++j;
+                if (pilots.size() == 1)
+                    e.pairs_.push_back({ 0, 0, T{1}, T{0} });
+                else
+                {
+                    const T lo = frequency(pilots[j]), hi = frequency(pilots[j + 1]);
+                    const T w = (f - lo) / (hi - lo);
+                    e.pairs_.push_back({ static_cast<uint32_t>(j), static_cast<uint32_t>(j + 1), 1 - w, w });
+                }
+            }
+            for (const auto& v: map.pilot_values())
+                e.inverse_.push_back(std::complex<T>(T{1} / v));
+            return e;
+        }
+
+        /**
+         * @brief Updates the estimate with the pilots of a demodulated symbol.
+         *
+         * @param bins The symbol in the FFT order, e.g. the output of ofdm::rx() past the cyclic prefix.
+         * @param polarity The sign of the pilots of the symbol.
+         */
+        std::expected<void, std::string> update(std::span<const std::complex<T>> bins, T polarity = 1)
+        {
+            if (bins.size() != map_.size())
+                return std::unexpected(std::format("The symbol size={} does not fit the map size={}", bins.size(), map_.size()));
+            if (polarity == 0)
+                return std::unexpected("The pilot polarity is zero");
+
+            const auto pilots = map_.pilot_bins();
+            const T inverse = 1 / polarity;
+            for (size_t i = 0; i < pilots.size(); ++i)
+                observed_[i] = bins[pilots[i]] * inverse_[i] * inverse;
+
+            const T alpha = revision_ == 0 ? T{1} : smoothing_;
+            for (size_t d = 0; d < pairs_.size(); ++d)
+            {
+                const auto& p = pairs_[d];
+                const std::complex<T> fresh = observed_[p.lo] * p.w_lo + observed_[p.hi] * p.w_hi;
+                estimate_[d] += (fresh - estimate_[d]) * alpha;
+            }
+            revision_ = next_revision();
+            return {};
+        }
+
+        // The channel at the data subcarriers in the order of the map
+        std::span<const std::complex<T>> estimate() const noexcept { return estimate_; }
+
+        // The stamp of the estimate, unique across all the estimators and updates; 0 before the first update
+        uint64_t revision() const noexcept { return revision_; }
+
+    private:
+        static uint64_t next_revision() noexcept
+        {
+            static std::atomic<uint64_t> revision{0};
+            return revision.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        // The neighbour pilots of a data subcarrier and their weights
+        struct pair
+        {
+            uint32_t    lo;
+            uint32_t    hi;
+            T           w_lo;
+            T           w_hi;
+        };
+
+        channel_estimator(const subcarrier_map& map, T smoothing)
+            : map_(map)
+            , smoothing_(smoothing)
+            , observed_(map.pilot_size())
+            , estimate_(map.data_size()) {}
+
+        subcarrier_map                  map_;
+        T                               smoothing_;
+        std::vector<pair>               pairs_;
+        std::vector<std::complex<T>>    inverse_;   // the inverse pilot values
+        std::vector<std::complex<T>>    observed_;
+        std::vector<std::complex<T>>    estimate_;
+        uint64_t                        revision_ = 0;
+    };
+
+    /**
+     * The one-tap equalizer: a complex weight per data subcarrier, the zero forcing 1 / H or, given the noise variance
+     * of the unit power constellations, the MMSE conj(H) / (|H|^2 + N0). The weights are computed only when the estimate
+     * changes, so equalizing a symbol is a vector complex multiply per subcarrier.
+     */
+    template <std::floating_point T>
+    class equalizer
+    {
+    public:
+        /**
+         * @brief Creates the equalizer.
+         *
+         * @param noise_variance N0 of the MMSE weights, 0 for the zero forcing.
+         * @param set Instruction set of the multiply, the widest one supported by the CPU by default.
+         * @return std::expected<equalizer, std::string>
+         * - The equalizer on success;
+         * - Error string on failure.
+         */
+        static std::expected<equalizer, std::string> create(T noise_variance = 0, simd::isa set = simd::detect())
+        {
+            if (!(noise_variance >= 0))
+                return std::unexpected(std::format("The noise variance={} is negative", noise_variance));
+            if (!simd::supported(set))
+                return std::unexpected(std::format("The instruction set {} is not supported by the CPU", simd::name(set)));
+            return equalizer(noise_variance, set);
+        }
+
+        /**
+         * @brief Equalizes the data subcarriers of a symbol in place.
+         *
+         * @param channel The estimate of the channel, the weights being recomputed once per its revision.
+         * @param data The data subcarriers in the order of the map, e.g. the output of ofdm::rx() of the map.
+         */
+        std::expected<void, std::string> apply(const channel_estimator<T>& channel, std::span<std::complex<T>> data)
+        {
+            const auto H = channel.estimate();
+            if (data.size() != H.size())
+                return std::unexpected(std::format("The {} data subcarriers do not fit the estimate of {}", data.size(), H.size()));
+
+            if (weights_.size() != H.size() || channel.revision() != revision_)
+            {
+                weights_.resize(H.size());
+                for (size_t i = 0; i < H.size(); ++i)
+                {
+                    const T power = std::norm(H[i]) + noise_variance_;
+                    weights_[i] = power > 0 ? std::conj(H[i]) / power : std::complex<T>{};
+                }
+                revision_ = channel.revision();
+            }
+            fft::detail::multiply(set_, data.data(), weights_.data(), data.size());
+            return {};
+        }
+
+        // Sets N0 of the MMSE weights, recomputed at the next symbol
+        std::expected<void, std::string> set_noise_variance(T noise_variance)
+        {
+            if (!(noise_variance >= 0))
+                return std::unexpected(std::format("The noise variance={} is negative", noise_variance));
+            noise_variance_ = noise_variance;
+            weights_.clear();
+            return {};
+        }
+
+    private:
+        equalizer(T noise_variance, simd::isa set)
+            : noise_variance_(noise_variance)
+            , set_(set) {}
+
+        T                               noise_variance_;
+        simd::isa                       set_;
+        std::vector<std::complex<T>>    weights_;
+        uint64_t                        revision_ = 0;      // the estimate the weights are of
+    };
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "simd.hpp"
+#include "fft_kernels.hpp"
+#include "fft_codelets.hpp"
+#include "parallel.hpp"
+#include "split_buffer.hpp"
 #include <stdint.h>
 #include <iterator>
 #include <complex>
@@ -7,11 +12,22 @@
 #include <type_traits>
 #include <concepts>
 #include <expected>
+#include <string>
+#include <format>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cmath>
+#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <bit>
+#include <span>
 
 namespace fft::detail
 {
     /**
-     * @brief Permutes elements of a container according to their reversed indexes.
+     * @brief Builds the swap table that permutes elements of a container according to their reversed indexes.
      * I.e.
      * 
      * value    index (dec/bin)   ---becomes--->   reversed index (dec/bin)   value
@@ -28,13 +44,15 @@ namespace fft::detail
      * Because (0,4) (2,6) (1,5) (3,7) are the pairs that FFT ends up processing in its leafs "down the stack"
      * before it starts building the sequence up again. By reversing the order, one ensures a sequential element access,
      * hence a boost in speed, as this is cache-friendly for CPU.
-     * @tparam It Any container possessing a random access iterator trait.
-     * @param begin A start iterator to the underlying data.
-     * @param size Size of the underlying data.
+     * @param size Size of the underlying data, a power of 2.
+     * @param index Receives the reversed index of every element.
+     * @param swaps Receives the (i, j), i < j, pairs to swap in order to permute the sequence.
      */
-    template <std::random_access_iterator It>
-    void bit_reverse_permute(It begin, size_t size)
+    inline void bit_reverse_table(size_t size, std::vector<uint32_t>& index, std::vector<std::pair<uint32_t, uint32_t>>& swaps)
     {
+        index.assign(size, 0);
+        swaps.clear();
+        swaps.reserve(size / 2);
         for (std::size_t i = 1, j = 0; i < size; ++i)
         {
             std::size_t zip = size >> 1; // Always start from the next to MSB: zip = ox*****
@@ -45,11 +63,25 @@ namespace fft::detail
             }
             j |= zip; // Ultimately as if +1 but bitwise reversed: j = ****x**
 
+            index[i] = static_cast<uint32_t>(j);
             if (i < j)
-                std::swap(*(begin + i), *(begin + j));
+                swaps.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
         }
     }
 
+    /**
+     * @brief Permutes elements of a container according to a precomputed swap table (see bit_reverse_table, digit_reverse_table).
+     * @tparam It Any container possessing a random access iterator trait.
+     * @param begin A start iterator to the underlying data.
+     * @param swaps The swap table.
+     */
+    template <std::random_access_iterator It>
+    void bit_reverse_permute(It begin, const std::vector<std::pair<uint32_t, uint32_t>>& swaps)
+    {
+        for (const auto& [i, j]: swaps)
+            std::swap(*(begin + i), *(begin + j));
+    }
+
     template <typename T>
     struct is_complex_t : public std::false_type {};
 
@@ -71,101 +103,865 @@ namespace fft::detail
                                    && detail::is_complex<std::iter_value_t<It>>;
 
     /**
-     * @brief Iterative (I)FFT based on Cooley-Tukey Radix-2 Decimation-In-Time algorithm.
+     * @brief Butterfly stages of the iterative (I)FFT based on Cooley-Tukey Radix-2 Decimation-In-Time algorithm.
      * The principal difference from the FFT recursive is in re-arranging the sequence in contiguous
-     * independent ranges that are CPU cache-friendly, and processing them in parallel using OpenMP.
+     * independent ranges that are CPU cache-friendly, and splitting every stage across threads.
+     * The sequence must already be in the bit-reversed order.
      * 
-     * @tparam ParallelThreshold Parallelize when the sequence size / 2 exceeds this number.
      * @tparam It An iterator type of a random access container with a std::complex underlying type.
      * @param begin A sequence start iterator.
-     * @param end A sequence end iterator.
-     * @param sign true for non-scaled IFFT of the sequence, otherwise false for FFT.
-     * @return std::expected<void, std::string> 
-     * - Nothing in case of success;
-     * - A string of error in case of failure.
+     * @param size A sequence size, a power of 2.
+     * @param twiddles Stage-wise twiddle tables: the stage of N = 2h points starts at twiddles[h - 1].
+     * @param parallel_threshold Split a stage across threads in chunks of at least this number of butterflies.
      */
-    template <size_t ParallelThreshold, fft_compatible_iterator It>
-    std::expected<void, std::string> cooley_tukey_iterative_fft(It begin, It end, bool inverse = false)
+    template <fft_compatible_iterator It>
+    void cooley_tukey_iterative_fft(It begin, size_t size, const std::iter_value_t<It>* twiddles, size_t parallel_threshold)
     {
-        const size_t size = std::distance(begin, end);
-        if (size > 0 && ((size & (size - 1)) != 0)) // Must be of powers of 2 size
-            return std::unexpected("The sequence size must be of powers of 2");
-
-        bit_reverse_permute(begin, size);
         for (size_t N = 2; N <= size; N <<= 1) // Avoiding std::log(size), just move by powers of 2
         {
-/* Apparently, this version accumulates FP error
-            const auto unity_root = std::polar(1.0, -2 * (inverse ? -1 : 1) * std::numbers::pi / N);
-            #pragma omp parallel for if(size / N > ParallelThreshold) // Parallelize independent blocks
-            for (size_t i = 0; i < size; i += N)
-            {
-                auto z = std::polar(1.0, 0.0);
-                for (size_t j = 0; j < N / 2; ++j)
-                {
-                    auto even = *(begin + i + j);
-                    auto odd = *(begin + i + j + N / 2) * z;
-                    *(begin + i + j) = even + odd;
-                    *(begin + i + j + N / 2) = even - odd;
-                    z *= unity_root;
-                }
-            }
-*/
-            using floating = typename std::iter_value_t<It>::value_type; // double or float from std::complex
-            const floating theta = -2.0 * (inverse ? -1.0 : 1.0) * std::numbers::pi / N;
-            const floating cos = std::cos(theta);
-            const floating sin = std::sin(theta);
+            const auto* w = twiddles + N / 2 - 1; // Exact unity roots of the stage, no recurrence to drift
 
-            // TODO(artem): consider SIMD improvements
-            #pragma omp parallel for if(size / N > ParallelWhenSizeIsLargerThan)
-            for (size_t i = 0; i < size; i += N)
+            // The butterfly b pairs the points i + j and i + j + N/2 of the block i = (b / (N/2)) * N, j = b % (N/2).
+            // Numbering the butterflies rather than the blocks keeps the late stages of few large blocks parallel too
+            parallel::for_range(size / 2, parallel_threshold, [begin, N, w](size_t first, size_t last)
             {
-                floating wr = 1.0;
-                floating wi = 0.0;
-            
-                for (size_t j = 0; j < N / 2; ++j)
+                for (size_t b = first; b != last; ++b)
                 {
+                    const size_t i = (b / (N / 2)) * N;
+                    const size_t j = b % (N / 2);
                     const auto even = *(begin + i + j);
                     const auto odd  = *(begin + i + j + N / 2);
                 
-                    const std::complex<floating> t
+                    const std::iter_value_t<It> t
                     {
-                        odd.real() * wr - odd.imag() * wi,
-                        odd.real() * wi + odd.imag() * wr
+                        odd.real() * w[j].real() - odd.imag() * w[j].imag(),
+                        odd.real() * w[j].imag() + odd.imag() * w[j].real()
                     };
                 
                     *(begin + i + j)         = even + t;
                     *(begin + i + j + N / 2) = even - t;
-                
-                    // Twiddle recurrence
-                    const floating tmp = wr;
-                    wr = tmp * cos - wi * sin;
-                    wi = tmp * sin + wi * cos;
-                
-                    // Optional renormalization (cheap safety net)
-                    if ((j & 31) == 0)
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Builds the swap table of the digit-reversal permutation, the mixed-radix generalization of the bit reversal.
+     * The Decimation-In-Time stage s combines radices[s] adjacent blocks, each holding the sub-transform of
+     * the elements congruent modulo radices[s], hence the element n of the last stage of radix r lands at
+     * (n mod r) * (size / r) + its position among the size / r elements of the previous stages.
+     * 
+     * @param size Size of the underlying data, the product of the radices.
+     * @param radices The radices of the stages, the first stage first.
+     * @param index Receives the permuted position of every element.
+     * @param swaps Receives the pairs to swap, in order, to permute the sequence in place.
+     */
+    inline void digit_reverse_table(size_t size, const std::vector<uint8_t>& radices, std::vector<uint32_t>& index, std::vector<std::pair<uint32_t, uint32_t>>& swaps)
+    {
+        index.assign(size, 0);
+        for (size_t n = 0; n < size; ++n)
+        {
+            size_t rest = n, span = size, pos = 0;
+            for (auto r = radices.rbegin(); r != radices.rend(); ++r)
+            {
+                span /= *r;
+                pos += (rest % *r) * span;
+                rest /= *r;
+            }
+            index[n] = static_cast<uint32_t>(pos);
+        }
+
+        // Emulating the placement of every element to record the swaps
+        std::vector<uint32_t> source(size), where(size), who(size);
+        for (size_t n = 0; n < size; ++n)
+        {
+            source[index[n]] = static_cast<uint32_t>(n);
+            where[n] = who[n] = static_cast<uint32_t>(n);
+        }
+        swaps.clear();
+        for (uint32_t t = 0; t < size; ++t)
+        {
+            const uint32_t cur = where[source[t]];
+            if (cur == t)
+                continue;
+            swaps.emplace_back(t, cur);
+            const uint32_t displaced = who[t];
+            where[displaced] = cur;
+            who[cur] = displaced;
+            where[source[t]] = t;
+            who[t] = source[t];
+        }
+    }
+
+    /**
+     * @brief The Decimation-In-Time stages of the mixed-radix (2, 3, 4, 5) FFT over a digit-reversed sequence.
+     * The stage of radix r combines r adjacent blocks of m points into blocks of L = r*m points:
+     * the point k of the block p is multiplied by w(L)^(p*k) and the r points then pass the DFT of r points.
+     * 
+     * @tparam It An iterator type of a random access container with a std::complex underlying type.
+     * @param begin A sequence start iterator.
+     * @param size A sequence size, the product of the radices.
+     * @param radices The radices of the stages, the first stage first.
+     * @param twiddles Stage-wise twiddles: w(L)^(p*k) is at [k * (r - 1) + p - 1] of the stage's table, tables follow each other.
+     * @param inverse true for IFFT, false for FFT.
+     */
+    template <fft_compatible_iterator It>
+    void mixed_radix_stages(It begin, size_t size, const std::vector<uint8_t>& radices, const std::iter_value_t<It>* twiddles, bool inverse)
+    {
+        using complex = std::iter_value_t<It>;
+        using floating = typename complex::value_type;
+
+        const floating sign = inverse ? 1 : -1;
+        const auto rotate = [sign](complex v) -> complex { return { -sign * v.imag(), sign * v.real() }; }; // v * (+-i)
+        const auto mul = [](complex a, complex w) -> complex
+        {
+            return { a.real() * w.real() - a.imag() * w.imag(), a.real() * w.imag() + a.imag() * w.real() };
+        };
+
+        // cos/sin of 2pi/3, 2pi/5 and 4pi/5
+        const floating s3 = std::sqrt(floating{3}) / 2;
+        const floating c51 = std::cos(2 * std::numbers::pi_v<floating> / 5), s51 = std::sin(2 * std::numbers::pi_v<floating> / 5);
+        const floating c52 = std::cos(4 * std::numbers::pi_v<floating> / 5), s52 = std::sin(4 * std::numbers::pi_v<floating> / 5);
+
+        size_t m = 1;
+        for (const size_t r: radices)
+        {
+            const size_t L = r * m;
+            for (size_t i = 0; i < size; i += L)
+            {
+                for (size_t k = 0; k < m; ++k)
+                {
+                    const auto* w = twiddles + k * (r - 1);
+                    complex t[5];
+                    t[0] = *(begin + i + k);
+                    for (size_t p = 1; p < r; ++p)
+                        t[p] = mul(*(begin + i + p * m + k), w[p - 1]);
+
+                    complex y[5];
+                    switch (r)
+                    {
+                    case 2:
+                        y[0] = t[0] + t[1];
+                        y[1] = t[0] - t[1];
+                        break;
+                    case 3:
+                    {
+                        const complex a = t[1] + t[2];
+                        const complex b = rotate((t[1] - t[2]) * s3);
+                        const complex c = t[0] - a * floating{0.5};
+                        y[0] = t[0] + a;
+                        y[1] = c + b;
+                        y[2] = c - b;
+                        break;
+                    }
+                    case 4:
+                    {
+                        const complex a0 = t[0] + t[2], a1 = t[0] - t[2];
+                        const complex a2 = t[1] + t[3], a3 = rotate(t[1] - t[3]);
+                        y[0] = a0 + a2;
+                        y[2] = a0 - a2;
+                        y[1] = a1 + a3;
+                        y[3] = a1 - a3;
+                        break;
+                    }
+                    case 5:
                     {
-                        const floating mag = std::hypot(wr, wi);
-                        wr /= mag;
-                        wi /= mag;
+                        const complex a1 = t[1] + t[4], b1 = t[1] - t[4];
+                        const complex a2 = t[2] + t[3], b2 = t[2] - t[3];
+                        const complex c1 = t[0] + a1 * c51 + a2 * c52;
+                        const complex c2 = t[0] + a1 * c52 + a2 * c51;
+                        const complex d1 = rotate(b1 * s51 + b2 * s52);
+                        const complex d2 = rotate(b1 * s52 - b2 * s51);
+                        y[0] = t[0] + a1 + a2;
+                        y[1] = c1 + d1;
+                        y[4] = c1 - d1;
+                        y[2] = c2 + d2;
+                        y[3] = c2 - d2;
+                        break;
+                    }
                     }
+
+                    for (size_t q = 0; q < r; ++q)
+                        *(begin + i + q * m + k) = y[q];
                 }
             }
+            twiddles += m * (r - 1);
+            m = L;
         }
-        return {};
     }
 }
 
-// TODO(artem): add FFTW lib as a seamless alternative
 namespace fft
 {
     template <typename It>
     concept fft_compatible_iterator = detail::fft_compatible_iterator<It>;
 
+    enum class direction
+    {
+        forward,
+        inverse // non-scaled
+    };
+
+    /**
+     * Placement of a batch of K equal-length transforms of N points in memory
+     */
+    enum class layout
+    {
+        contiguous, // The transform k occupies [k * N, (k + 1) * N)
+        interleaved // The point n of the transform k is at n * K + k, the butterflies are vectorized across the transforms
+    };
+
+    /**
+     * @brief A precomputed FFT of a fixed size and direction.
+     * Owns the exact twiddle tables of every stage and the permutation tables, so that executing
+     * the transform costs no trigonometry, no twiddle recurrence and no index bit-twiddling.
+     * Create once per size and direction, then execute as many times as needed.
+     * The algorithm depends on the size:
+     * - powers of 2 run the radix-2/4 Cooley-Tukey, contiguous sequences are transformed by the vector
+     *   butterfly kernels of the instruction set chosen at creation, the tiny ones by the unrolled codelets;
+     * - products of 2, 3 and 5 run the mixed-radix Cooley-Tukey;
+     * - any other size runs the Bluestein chirp-z algorithm as a convolution by power of 2 FFTs.
+     * Powers of 2 may select the out-of-place Stockham autosort instead: it reads and writes every stage
+     * sequentially and skips the cache-hostile bit-reversal pass, which pays off for the out-of-place
+     * execution of large sizes.
+     * Powers of 2 from four_step_size on multi-core machines run the four-step algorithm: the sequence is viewed as a matrix
+     * of N1 rows by N2 columns, N1 * N2 = N, and transformed by the N2 column FFTs, the twiddle
+     * multiplication, the N1 row FFTs and the transposition. The sub-FFTs of about sqrt(N) points fit
+     * the L2 cache, and every step is split across threads.
+     * 
+     * @tparam T double or float.
+     */
+    template <std::floating_point T>
+    class plan
+    {
+    public:
+        enum class algorithm
+        {
+            radix2,      // In-place Cooley-Tukey, powers of 2
+            stockham,    // Out-of-place Stockham autosort, powers of 2, no bit reversal
+            four_step,   // Cache-blocked four-step, large powers of 2, every step split across threads
+            mixed_radix, // In-place Cooley-Tukey, products of 2, 3 and 5
+            bluestein    // Chirp-z, any size
+        };
+
+        // The smallest power of 2 size run by the four-step algorithm by default on multi-core machines
+        static constexpr size_t four_step_size = size_t{1} << 18;
+
+        /**
+         * @brief Creates the plan.
+         * 
+         * @param size Size of the sequences to transform.
+         * @param dir Direction of the transform; the inverse one is non-scaled.
+         * @param set Instruction set of the butterfly kernels, the widest one supported by the CPU by default.
+         * @param kind The algorithm to use instead of the one chosen by the size, must suit the size.
+         * @return std::expected<plan, std::string> 
+         * - The plan on success;
+         * - Error string on failure.
+         */
+        static std::expected<plan, std::string> create(size_t size, direction dir = direction::forward, simd::isa set = simd::detect(),
+                                                       std::optional<algorithm> kind = std::nullopt)
+        {
+            if (!simd::supported(set))
+                return std::unexpected(std::format("The instruction set {} is not supported by the CPU", simd::name(set)));
+            if (size > std::numeric_limits<uint32_t>::max() / 4)
+                return std::unexpected("The sequence size exceeds the supported maximum");
+
+            plan p;
+            p.size_ = size;
+            p.dir_ = dir;
+            p.isa_ = set;
+
+            size_t rest = size;
+            for (const uint8_t r: {4, 2, 3, 5})
+                for (; rest > 0 && rest % r == 0; rest /= r)
+                    p.radices_.push_back(r);
+
+            const bool pow2 = (size & (size - 1)) == 0;
+            // On a single core the four-step runs about as fast as the in-place Cooley-Tukey up to 2^22 points
+            // and faster beyond, while it is the only one to split every stage across threads
+            const bool large = size >= four_step_size && (parallel::concurrency() > 1 || size >= (four_step_size << 6));
+            p.algorithm_ = kind.value_or(pow2 ? (large ? algorithm::four_step : algorithm::radix2)
+                                              : rest == 1 ? algorithm::mixed_radix : algorithm::bluestein);
+            if ((p.algorithm_ == algorithm::radix2 || p.algorithm_ == algorithm::stockham) && !pow2)
+                return std::unexpected(std::format("The algorithm requires a power of 2 size, got {}", size));
+            if (p.algorithm_ == algorithm::four_step && (!pow2 || size < 4))
+                return std::unexpected(std::format("The algorithm requires a power of 2 size of at least 4, got {}", size));
+
+            if (p.algorithm_ == algorithm::four_step)
+            {
+                size_t N1 = 1;
+                while (N1 * N1 < size)
+                    N1 <<= 1;
+                const size_t N2 = size / N1;
+
+                auto cols = plan::create(N1, dir, set, algorithm::radix2);
+                auto rows = plan::create(N2, dir, set, algorithm::radix2);
+                if (!cols)
+                    return std::unexpected(cols.error());
+                if (!rows)
+                    return std::unexpected(rows.error());
+                p.cols_ = std::make_shared<const plan>(std::move(*cols));
+                p.rows_ = std::make_shared<const plan>(std::move(*rows));
+
+                // w(N)^e = w(N)^(q * N2) * w(N)^r, e = q * N2 + r: two tables of sqrt(N) instead of one of N
+                p.radices_.clear();
+                p.twiddles_.resize(N1 + N2);
+                for (size_t q = 0; q < N1; ++q)
+                    p.twiddles_[q] = root(q * N2, size, dir);
+                for (size_t r = 0; r < N2; ++r)
+                    p.twiddles_[N1 + r] = root(r, size, dir);
+                return p;
+            }
+            if (p.algorithm_ == algorithm::mixed_radix && rest != 1)
+                return std::unexpected(std::format("The algorithm requires a product of 2, 3 and 5 size, got {}", size));
+            if (p.algorithm_ == algorithm::bluestein && size == 0)
+                return std::unexpected("The algorithm requires a non-empty sequence");
+
+            if (p.algorithm_ == algorithm::radix2 || p.algorithm_ == algorithm::stockham)
+            {
+                p.radices_.clear();
+                if (p.algorithm_ == algorithm::radix2) // Stockham sorts itself
+                    detail::bit_reverse_table(size, p.index_, p.swaps_);
+
+                // The roots of the largest stage, computed directly in extended precision.
+                // Every smaller stage uses a strided subset of them: w(N)^j == w(size)^(j * size / N)
+                std::vector<std::complex<T>> roots(size / 2);
+                for (size_t j = 0; j < roots.size(); ++j)
+                    roots[j] = root(j, size, dir);
+
+                p.twiddles_.reserve(size > 0 ? size - 1 : 0);
+                for (size_t N = 2; N <= size; N <<= 1)
+                    for (size_t j = 0; j < N / 2; ++j)
+                        p.twiddles_.push_back(roots[j * (size / N)]);
+
+                p.twiddles_re_.reserve(p.twiddles_.size());
+                p.twiddles_im_.reserve(p.twiddles_.size());
+                for (const auto& w: p.twiddles_)
+                {
+                    p.twiddles_re_.push_back(w.real());
+                    p.twiddles_im_.push_back(w.imag());
+                }
+                return p;
+            }
+
+            if (p.algorithm_ == algorithm::mixed_radix)
+            {
+                detail::digit_reverse_table(size, p.radices_, p.index_, p.swaps_);
+
+                size_t m = 1;
+                for (const size_t r: p.radices_)
+                {
+                    for (size_t k = 0; k < m; ++k)
+                        for (size_t q = 1; q < r; ++q)
+                            p.twiddles_.push_back(root(q * k, r * m, dir));
+                    m *= r;
+                }
+                return p;
+            }
+
+            // Bluestein: X[k] = c[k] * sum(x[n] * c[n] * conj(c[k - n])), c[n] = w(2N)^(n^2),
+            // i.e. a convolution computed by the power of 2 FFTs of at least 2N - 1 points
+            p.radices_.clear();
+            size_t M = 1;
+            while (M < 2 * size - 1)
+                M <<= 1;
+
+            p.chirp_.resize(size);
+            for (size_t n = 0; n < size; ++n)
+                p.chirp_[n] = root((n * n) % (2 * size), 2 * size, dir);
+
+            std::vector<std::complex<T>> filter(M);
+            for (size_t n = 0; n < size; ++n)
+                filter[n] = filter[(M - n) % M] = std::conj(p.chirp_[n]) / static_cast<T>(M); // The IFFT scaling folded in
+
+            auto forward = plan::create(M, direction::forward, set);
+            auto inverse = plan::create(M, direction::inverse, set);
+            if (!forward)
+                return std::unexpected(forward.error());
+            if (!inverse)
+                return std::unexpected(inverse.error());
+
+            forward->transform(filter.data(), std::numeric_limits<size_t>::max());
+            p.spectrum_ = std::move(filter);
+            p.forward_ = std::make_shared<const plan>(std::move(*forward));
+            p.inverse_ = std::make_shared<const plan>(std::move(*inverse));
+            return p;
+        }
+
+        /**
+         * @brief Transforms the sequence in place.
+         * 
+         * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points.
+         * @tparam It An iterator type of a random access container with a std::complex<T> underlying type.
+         * @param begin A sequence begin iterator.
+         * @param end A sequence end iterator.
+         * @return std::expected<void, std::string> 
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>>
+        std::expected<void, std::string> execute(It begin, It end) const
+        {
+            return execute(begin, end, ParallelThreshold);
+        }
+
+        /**
+         * @brief Transforms the sequence in place, the parallel threshold given at run time, e.g. through a backend.
+         *
+         * @param parallel_threshold Split the work of a stage across threads in chunks of at least this number of points.
+         */
+        template <fft_compatible_iterator It>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>>
+        std::expected<void, std::string> execute(It begin, It end, size_t parallel_threshold) const
+        {
+            if (static_cast<size_t>(std::distance(begin, end)) != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+
+            transform(begin, parallel_threshold);
+            return {};
+        }
+
+        /**
+         * @brief Transforms the sequence out of place, leaving the source intact.
+         * Stockham plans read the source directly, the others transform a copy in the destination.
+         * 
+         * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points.
+         * @param begin A source sequence begin iterator.
+         * @param end A source sequence end iterator.
+         * @param out A destination begin iterator, the destination must not overlap the source.
+         * @return std::expected<void, std::string> 
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        template <size_t ParallelThreshold = 1024, fft_compatible_iterator It, fft_compatible_iterator Out>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>> && std::same_as<std::iter_value_t<Out>, std::complex<T>>
+        std::expected<void, std::string> execute(It begin, It end, Out out) const
+        {
+            if (static_cast<size_t>(std::distance(begin, end)) != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+
+            if constexpr (std::contiguous_iterator<It> && std::contiguous_iterator<Out>)
+            {
+                if (algorithm_ == algorithm::stockham)
+                {
+                    stockham(std::to_address(begin), std::to_address(out));
+                    return {};
+                }
+            }
+            std::copy(begin, end, out);
+            transform(out, ParallelThreshold);
+            return {};
+        }
+
+        /**
+         * @brief Transforms the sequence already laid out in the order of permutation() in place, skipping the reordering.
+         * Lets a producer write every element straight to its permuted position: the element n goes to permutation()[n].
+         * 
+         * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points.
+         * @tparam It An iterator type of a random access container with a std::complex<T> underlying type.
+         * @param begin A permuted sequence begin iterator.
+         * @param end A permuted sequence end iterator.
+         * @return std::expected<void, std::string> 
+         * - Nothing on success;
+         * - Error string on failure, e.g. the plan has no permutation.
+         */
+        template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>>
+        std::expected<void, std::string> execute_permuted(It begin, It end) const
+        {
+            if (static_cast<size_t>(std::distance(begin, end)) != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+            if (algorithm_ != algorithm::radix2 && algorithm_ != algorithm::mixed_radix)
+                return std::unexpected("The plan takes the sequence in the natural order");
+
+            stages(begin, ParallelThreshold);
+            return {};
+        }
+
+        /**
+         * @brief Transforms the sequence in the split layout in place.
+         * Power of 2 plans run the split butterfly kernels directly, the others go through an interleaved copy.
+         * 
+         * @param re The real parts of the sequence.
+         * @param im The imaginary parts of the sequence.
+         * @return std::expected<void, std::string> 
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        std::expected<void, std::string> execute(std::span<T> re, std::span<T> im) const
+        {
+            if (re.size() != size_ || im.size() != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+
+            if (algorithm_ == algorithm::radix2)
+            {
+                detail::bit_reverse_permute(re.begin(), swaps_);
+                detail::bit_reverse_permute(im.begin(), swaps_);
+                detail::butterflies_split(isa_, re.data(), im.data(), size_, twiddles_re_.data(), twiddles_im_.data());
+                return {};
+            }
+
+            thread_local std::vector<std::complex<T>> work;
+            work.resize(size_);
+            for (size_t n = 0; n < size_; ++n)
+                work[n] = { re[n], im[n] };
+            transform(work.data(), std::numeric_limits<size_t>::max());
+            for (size_t n = 0; n < size_; ++n)
+            {
+                re[n] = work[n].real();
+                im[n] = work[n].imag();
+            }
+            return {};
+        }
+
+        /**
+         * @brief Transforms a batch of sequences of the plan size in place, splitting the batch across threads if large.
+         * 
+         * @tparam ParallelThreshold Split the batch across threads when it holds more points than this number per thread.
+         * @tparam It A contiguous iterator type with a std::complex<T> underlying type.
+         * @param begin The batch begin iterator.
+         * @param count The number of the sequences in the batch.
+         * @param order The layout of the batch.
+         * @param distance The contiguous layout only: the distance between the starts of the adjacent sequences,
+         * which may exceed the plan size to skip gaps; the plan size if 0.
+         * @return std::expected<void, std::string> 
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        template <size_t ParallelThreshold = 65536, std::contiguous_iterator It>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>>
+        std::expected<void, std::string> execute_batch(It begin, size_t count, layout order = layout::contiguous, size_t distance = 0) const
+        {
+            distance = distance ? distance : size_;
+            if (distance < size_)
+                return std::unexpected(std::format("The distance={} between the sequences is less than the plan size={}", distance, size_));
+
+            std::complex<T>* x = std::to_address(begin);
+            const size_t grain = std::max<size_t>(1, ParallelThreshold / std::max<size_t>(size_, 1));
+            if (order == layout::contiguous)
+            {
+                parallel::for_range(count, grain, [this, x, distance](size_t first, size_t last)
+                {
+                    for (size_t k = first; k != last; ++k)
+                        transform(x + k * distance, std::numeric_limits<size_t>::max());
+                });
+            }
+            else if (algorithm_ == algorithm::radix2)
+            {
+                parallel::for_range(count, grain, [this, x, count](size_t first, size_t last)
+                {
+                    for (const auto& [i, j]: swaps_) // Whole rows of the batch are permuted
+                        std::swap_ranges(x + i * count + first, x + i * count + last, x + j * count + first);
+                    detail::butterflies_interleaved(isa_, x + first, size_, count, last - first, twiddles_.data());
+                });
+            }
+            else
+            {
+                parallel::for_range(count, grain, [this, x, count](size_t first, size_t last)
+                {
+                    std::vector<std::complex<T>> column(size_);
+                    for (size_t k = first; k != last; ++k)
+                    {
+                        for (size_t n = 0; n < size_; ++n)
+                            column[n] = x[n * count + k];
+                        transform(column.data(), std::numeric_limits<size_t>::max());
+                        for (size_t n = 0; n < size_; ++n)
+                            x[n * count + k] = column[n];
+                    }
+                });
+            }
+            return {};
+        }
+
+        size_t size() const noexcept { return size_; }
+        direction dir() const noexcept { return dir_; }
+        simd::isa isa() const noexcept { return isa_; }
+        algorithm kind() const noexcept { return algorithm_; }
+
+        // The position of every element of the sequence after the bit (digit) reversal, empty for Stockham, four-step and Bluestein
+        const std::vector<uint32_t>& permutation() const noexcept { return index_; }
+
+    private:
+        plan() = default;
+
+        static std::complex<T> root(size_t k, size_t N, direction dir)
+        {
+            // w(N)^k computed directly in extended precision
+            const long double sign = dir == direction::inverse ? 1.0L : -1.0L;
+            const long double theta = sign * 2.0L * std::numbers::pi_v<long double> * k / N;
+            return { static_cast<T>(std::cos(theta)), static_cast<T>(std::sin(theta)) };
+        }
+
+        template <fft_compatible_iterator It>
+        void transform(It begin, size_t parallel_threshold) const
+        {
+            switch (algorithm_)
+            {
+            case algorithm::radix2:
+                if (size_ <= detail::codelet::forward_size)
+                {
+                    if (dir_ == direction::inverse)
+                        detail::codelet::dispatch<true, false>(begin, size_);
+                    else
+                        detail::codelet::dispatch<false, false>(begin, size_);
+                    break;
+                }
+                detail::bit_reverse_permute(begin, swaps_);
+                stages(begin, parallel_threshold);
+                break;
+            case algorithm::stockham:
+            {
+                thread_local std::vector<std::complex<T>> work;
+                work.assign(begin, begin + size_);
+                if constexpr (std::contiguous_iterator<It>)
+                    stockham(work.data(), std::to_address(begin));
+                else
+                {
+                    thread_local std::vector<std::complex<T>> out;
+                    out.resize(size_);
+                    stockham(work.data(), out.data());
+                    std::copy(out.begin(), out.end(), begin);
+                }
+                break;
+            }
+            case algorithm::four_step:
+                if constexpr (std::contiguous_iterator<It>)
+                    four_step(std::to_address(begin), parallel_threshold);
+                else
+                {
+                    thread_local std::vector<std::complex<T>> work;
+                    work.assign(begin, begin + size_);
+                    four_step(work.data(), parallel_threshold);
+                    std::copy(work.begin(), work.end(), begin);
+                }
+                break;
+            case algorithm::mixed_radix:
+                detail::bit_reverse_permute(begin, swaps_);
+                stages(begin, parallel_threshold);
+                break;
+            case algorithm::bluestein:
+                bluestein(begin);
+                break;
+            }
+        }
+
+        // The butterflies of the radix-2 and the mixed-radix plans over the sequence in the order of permutation()
+        template <fft_compatible_iterator It>
+        void stages(It begin, size_t parallel_threshold) const
+        {
+            if (algorithm_ == algorithm::mixed_radix)
+                detail::mixed_radix_stages(begin, size_, radices_, twiddles_.data(), dir_ == direction::inverse);
+            else if constexpr (std::contiguous_iterator<It>)
+                detail::butterflies(isa_, std::to_address(begin), size_, twiddles_.data(), dir_ == direction::inverse);
+            else
+                detail::cooley_tukey_iterative_fft(begin, size_, twiddles_.data(), parallel_threshold);
+        }
+
+        void four_step(std::complex<T>* x, size_t parallel_threshold) const
+        {
+            const size_t N1 = cols_->size_;
+            const size_t N2 = rows_->size_;
+
+            // The rows of the matrix are a power of 2 apart, so the blocks of columns are gathered into
+            // contiguous buffers first: the strided accesses would hit the same cache sets otherwise
+            static constexpr size_t block = 16;
+            const size_t width = std::min(block, N2);
+
+            // 1. The N2 column FFTs of N1 points, vectorized across the blocks of adjacent columns,
+            // and 2. the twiddles w(N)^(k1 * n2) applied on the way back
+            parallel::for_range(N2 / width, std::max<size_t>(1, parallel_threshold / (width * N1)), [this, x, N1, N2, width](size_t first, size_t last)
+            {
+                const size_t shift = std::countr_zero(N2);
+                const std::complex<T>* coarse = twiddles_.data();
+                const std::complex<T>* fine = coarse + N1;
+                const auto& reversed = cols_->index_;
+
+                thread_local std::vector<std::complex<T>> buffer;
+                buffer.resize(N1 * width);
+                std::complex<T>* b = buffer.data();
+                for (size_t c0 = first * width; c0 != last * width; c0 += width)
+                {
+                    for (size_t n1 = 0; n1 < N1; ++n1)
+                        std::copy(x + n1 * N2 + c0, x + n1 * N2 + c0 + width, b + reversed[n1] * width);
+                    detail::butterflies_interleaved(isa_, b, N1, width, width, cols_->twiddles_.data());
+
+                    for (size_t k1 = 0; k1 < N1; ++k1)
+                    {
+                        for (size_t c = 0, e = k1 * c0; c < width; ++c, e += k1)
+                        {
+                            const std::complex<T> u = coarse[e >> shift];
+                            const std::complex<T> v = fine[e & (N2 - 1)];
+                            const std::complex<T> w { u.real() * v.real() - u.imag() * v.imag(), u.real() * v.imag() + u.imag() * v.real() };
+                            const std::complex<T> a = b[k1 * width + c];
+                            x[k1 * N2 + c0 + c] = { a.real() * w.real() - a.imag() * w.imag(), a.real() * w.imag() + a.imag() * w.real() };
+                        }
+                    }
+                }
+            });
+
+            // 3. The N1 row FFTs of N2 points and 4. the transposition: X[k1 + N1 * k2] is at [k1 * N2 + k2].
+            // The rows are transposed by groups as soon as they are transformed, while still in the cache
+            thread_local std::vector<std::complex<T>> scratch;
+            scratch.resize(size_);
+            std::complex<T>* y = scratch.data();
+            const size_t group = std::min(block, N1);
+            parallel::for_range(N1 / group, std::max<size_t>(1, parallel_threshold / (group * N2)), [this, x, y, N1, N2, group](size_t first, size_t last)
+            {
+                for (size_t r0 = first * group; r0 != last * group; r0 += group)
+                {
+                    for (size_t k1 = r0; k1 < r0 + group; ++k1)
+                        rows_->transform(x + k1 * N2, std::numeric_limits<size_t>::max());
+                    for (size_t k2 = 0; k2 < N2; ++k2)
+                        for (size_t k1 = r0; k1 < r0 + group; ++k1)
+                            y[k2 * N1 + k1] = x[k1 * N2 + k2];
+                }
+            });
+            parallel::for_range(size_, parallel_threshold, [x, y](size_t first, size_t last)
+            {
+                std::copy(y + first, y + last, x + first);
+            });
+        }
+
+        void stockham(const std::complex<T>* src, std::complex<T>* dst) const
+        {
+            thread_local std::vector<std::complex<T>> scratch;
+            scratch.resize(size_);
+            detail::stockham(isa_, src, dst, scratch.data(), size_, twiddles_.data(), dir_ == direction::inverse);
+        }
+
+        template <fft_compatible_iterator It>
+        void bluestein(It begin) const
+        {
+            const auto mul = [](std::complex<T> a, std::complex<T> w) -> std::complex<T>
+            {
+                return { a.real() * w.real() - a.imag() * w.imag(), a.real() * w.imag() + a.imag() * w.real() };
+            };
+
+            thread_local std::vector<std::complex<T>> work;
+            work.assign(spectrum_.size(), {});
+            for (size_t n = 0; n < size_; ++n)
+                work[n] = mul(*(begin + n), chirp_[n]);
+
+            forward_->transform(work.data(), std::numeric_limits<size_t>::max());
+            detail::multiply(isa_, work.data(), spectrum_.data(), work.size());
+            inverse_->transform(work.data(), std::numeric_limits<size_t>::max());
+
+            for (size_t k = 0; k < size_; ++k)
+                *(begin + k) = mul(work[k], chirp_[k]);
+        }
+
+        size_t                                      size_ = 0;
+        direction                                   dir_ = direction::forward;
+        simd::isa                                   isa_ = simd::isa::scalar;
+        algorithm                                   algorithm_ = algorithm::radix2;
+        std::vector<std::complex<T>>                twiddles_; // radix2: the stage of N = 2h points occupies [h - 1, 2h - 1)
+                                                               // four_step: w(N)^(q * N2) for q < N1, then w(N)^r for r < N2
+        std::vector<T>                              twiddles_re_; // radix2: twiddles_ in the split layout
+        std::vector<T>                              twiddles_im_;
+        std::vector<uint32_t>                       index_;
+        std::vector<std::pair<uint32_t, uint32_t>>  swaps_;
+        std::vector<uint8_t>                        radices_;  // mixed_radix: the radices of the stages
+        std::vector<std::complex<T>>                chirp_;    // bluestein: w(2N)^(n^2)
+        std::vector<std::complex<T>>                spectrum_; // bluestein: FFT of the conjugated chirp, scaled by 1/M
+        std::shared_ptr<const plan>                 forward_;  // bluestein: the power of 2 convolution plans
+        std::shared_ptr<const plan>                 inverse_;
+        std::shared_ptr<const plan>                 cols_;     // four_step: the column and the row FFTs
+        std::shared_ptr<const plan>                 rows_;
+    };
+
+    namespace detail
+    {
+        /**
+         * @brief Provides a plan of the calling thread for the given size and direction, creating it on the first use.
+         * 
+         * @tparam Plan A plan type created by Plan::create(size, dir).
+         */
+        template <typename Plan>
+        std::expected<const Plan*, std::string> cached(size_t size, direction dir)
+        {
+            thread_local std::unordered_map<size_t, Plan> plans[2];
+
+            auto& cache = plans[dir == direction::inverse];
+            if (auto it = cache.find(size); it != cache.end())
+                return &it->second;
+
+            return Plan::create(size, dir)
+                .transform([&cache, size](Plan&& p) -> const Plan*
+                {
+                    return &cache.emplace(size, std::move(p)).first->second;
+                });
+        }
+
+        template <std::floating_point T>
+        std::expected<const plan<T>*, std::string> cached_plan(size_t size, direction dir)
+        {
+            return cached<plan<T>>(size, dir);
+        }
+    }
+
+    template <std::floating_point T>
+    class backend;
+
+    template <std::floating_point T>
+    class registry;
+
+    /**
+     * @brief Performs FFT of the sequence with the given plan.
+     * 
+     * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points.
+     * @tparam It An iterator type of a random access container with a std::complex underlying type.
+     * @param p A forward plan of the sequence size.
+     * @param begin A sequence begin iterator.
+     * @param end A sequence end iterator.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
+    std::expected<void, std::string> fft2(const plan<typename std::iter_value_t<It>::value_type>& p, It begin, It end)
+    {
+        if (p.dir() != direction::forward)
+            return std::unexpected("The plan is not of the forward direction");
+        return p.template execute<ParallelThreshold>(begin, end);
+    }
+
+    /**
+     * @brief Performs IFFT of the sequence with the given plan.
+     * 
+     * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points.
+     * @tparam It An iterator type of a random access container with a std::complex underlying type.
+     * @param p An inverse plan of the sequence size.
+     * @param begin A sequence begin iterator.
+     * @param end A sequence end iterator.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
+    std::expected<void, std::string> ifft2(const plan<typename std::iter_value_t<It>::value_type>& p, It begin, It end)
+    {
+        if (p.dir() != direction::inverse)
+            return std::unexpected("The plan is not of the inverse direction");
+        return p.template execute<ParallelThreshold>(begin, end)
+            .and_then([begin, end]() -> std::expected<void, std::string>
+            {
+                const auto N = std::distance(begin, end);
+                for (auto it = begin; it != end; ++it)
+                    *it /= N;
+                return {};
+            }); // monadic action on success: scaling down and resetting return to void
+    }
+
     /**
      * @brief Performs FFT of the sequence.
      * Attempts to be efficient employing parallelization in the iterative Cooley-Tukey FFT algorithm.
+     * Powers of 2 up to 16 run the unrolled codelets of fft2<N>. Contiguous sequences of any other size
+     * run the fastest backend of the registry, the others run a plan created on the first use and kept
+     * for the calling thread.
      * 
-     * @tparam ParallelThreshold Parallelize when the sequence size / 2 exceeds this number.
+     * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points,
+     * passed to the backend of a contiguous sequence, which may run with its own settings instead.
      * @tparam It An iterator type of a random access container with a std::complex underlying type.
      * @param begin A sequence begin iterator.
      * @param end A sequence end iterator.
@@ -176,14 +972,31 @@ namespace fft
     template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
     std::expected<void, std::string> fft2(It begin, It end)
     {
-        return detail::cooley_tukey_iterative_fft<ParallelThreshold>(begin, end);
+        const size_t size = std::distance(begin, end);
+        if (detail::codelet::dispatch<false, false>(begin, size))
+            return {};
+
+        using floating = typename std::iter_value_t<It>::value_type; // double or float from std::complex
+        if constexpr (std::contiguous_iterator<It>)
+            return registry<floating>::instance().select(size, direction::forward)
+                .execute(std::to_address(begin), size, direction::forward, ParallelThreshold);
+        else
+            return detail::cached_plan<floating>(size, direction::forward)
+                .and_then([begin, end](const plan<floating>* p)
+                {
+                    return fft2<ParallelThreshold>(*p, begin, end);
+                });
     }
 
     /**
      * @brief Performs IFFT of the sequence.
      * Attempts to be efficient employing parallelization in the iterative Cooley-Tukey FFT algorithm.
+     * Powers of 2 up to 16 run the unrolled codelets of fft2<N>. Contiguous sequences of any other size
+     * run the fastest backend of the registry, the others run a plan created on the first use and kept
+     * for the calling thread.
      * 
-     * @tparam ParallelThreshold Parallelize when the sequence size / 2 exceeds this number.
+     * @tparam ParallelThreshold Split the work of a stage across threads in chunks of at least this number of points,
+     * passed to the backend of a contiguous sequence, which may run with its own settings instead.
      * @tparam It An iterator type of a random access container with a std::complex underlying type.
      * @param begin A sequence begin iterator.
      * @param end A sequence end iterator.
@@ -194,13 +1007,224 @@ namespace fft
     template <size_t ParallelThreshold = 1024, fft_compatible_iterator It>
     std::expected<void, std::string> ifft2(It begin, It end)
     {
-        return detail::cooley_tukey_iterative_fft<ParallelThreshold>(begin, end, true)
-            .and_then([begin, end]() -> std::expected<void, std::string>
+        const size_t size = std::distance(begin, end);
+        if (detail::codelet::dispatch<true, true>(begin, size))
+            return {};
+
+        using floating = typename std::iter_value_t<It>::value_type; // double or float from std::complex
+        if constexpr (std::contiguous_iterator<It>)
+            return registry<floating>::instance().select(size, direction::inverse)
+                .execute(std::to_address(begin), size, direction::inverse, ParallelThreshold)
+                .transform([begin, size]()
+                {
+                    for (auto it = begin; it != begin + size; ++it)
+                        *it /= static_cast<floating>(size);
+                });
+        else
+            return detail::cached_plan<floating>(size, direction::inverse)
+                .and_then([begin, end](const plan<floating>* p)
+                {
+                    return ifft2<ParallelThreshold>(*p, begin, end);
+                });
+    }
+
+    /**
+     * @brief Performs FFT of N points as straight-line code generated at compile time: no loops, no tables
+     * and no plan, the twiddles are constants and the trivial ones cost no multiplication.
+     * Beats the plans up to 16 points, see detail::codelet::forward_size.
+     * 
+     * @tparam N The sequence size, a power of 2 from 2 to 256.
+     * @tparam It An iterator type of a random access container with a std::complex underlying type.
+     * @param begin A sequence begin iterator, N elements.
+     */
+    template <size_t N, fft_compatible_iterator It>
+        requires (N >= detail::codelet::min_size && N <= detail::codelet::max_size && (N & (N - 1)) == 0)
+    void fft2(It begin)
+    {
+        detail::codelet::transform<N, false, false>(begin);
+    }
+
+    /**
+     * @brief Performs IFFT of N points as straight-line code generated at compile time, see fft2<N>.
+     * 
+     * @tparam N The sequence size, a power of 2 from 2 to 256.
+     * @tparam It An iterator type of a random access container with a std::complex underlying type.
+     * @param begin A sequence begin iterator, N elements.
+     */
+    template <size_t N, fft_compatible_iterator It>
+        requires (N >= detail::codelet::min_size && N <= detail::codelet::max_size && (N & (N - 1)) == 0)
+    void ifft2(It begin)
+    {
+        detail::codelet::transform<N, true, true>(begin);
+    }
+
+    /**
+     * @brief Performs FFT of a contiguous batch of equal-length sequences with the given plan.
+     * 
+     * @tparam ParallelThreshold Split the batch across threads when it holds more points than this number per thread.
+     * @tparam It A contiguous iterator type with a std::complex underlying type.
+     * @param p A forward plan of the sequence size.
+     * @param begin The batch begin iterator.
+     * @param end The batch end iterator, the batch size must be a multiple of the plan size.
+     * @param order The layout of the batch.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 65536, std::contiguous_iterator It>
+        requires fft_compatible_iterator<It>
+    std::expected<void, std::string> fft2_batch(const plan<typename std::iter_value_t<It>::value_type>& p, It begin, It end, layout order = layout::contiguous)
+    {
+        if (p.dir() != direction::forward)
+            return std::unexpected("The plan is not of the forward direction");
+
+        const size_t total = std::distance(begin, end);
+        if (p.size() == 0 || total % p.size() != 0)
+            return std::unexpected(std::format("The batch size={} is not a multiple of the plan size={}", total, p.size()));
+        return p.template execute_batch<ParallelThreshold>(begin, total / p.size(), order);
+    }
+
+    /**
+     * @brief Performs IFFT of a contiguous batch of equal-length sequences with the given plan.
+     * 
+     * @tparam ParallelThreshold Split the batch across threads when it holds more points than this number per thread.
+     * @tparam It A contiguous iterator type with a std::complex underlying type.
+     * @param p An inverse plan of the sequence size.
+     * @param begin The batch begin iterator.
+     * @param end The batch end iterator, the batch size must be a multiple of the plan size.
+     * @param order The layout of the batch.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 65536, std::contiguous_iterator It>
+        requires fft_compatible_iterator<It>
+    std::expected<void, std::string> ifft2_batch(const plan<typename std::iter_value_t<It>::value_type>& p, It begin, It end, layout order = layout::contiguous)
+    {
+        if (p.dir() != direction::inverse)
+            return std::unexpected("The plan is not of the inverse direction");
+
+        const size_t total = std::distance(begin, end);
+        if (p.size() == 0 || total % p.size() != 0)
+            return std::unexpected(std::format("The batch size={} is not a multiple of the plan size={}", total, p.size()));
+        return p.template execute_batch<ParallelThreshold>(begin, total / p.size(), order)
+            .and_then([begin, end, N = p.size()]() -> std::expected<void, std::string>
             {
-                const auto N = std::distance(begin, end);
+                using floating = typename std::iter_value_t<It>::value_type;
+                const floating scale = floating{1} / N;
                 for (auto it = begin; it != end; ++it)
-                    *it /= N;
+                    *it *= scale;
                 return {};
             }); // monadic action on success: scaling down and resetting return to void
     }
-}
\ No newline at end of file
+
+    /**
+     * @brief Performs FFT of a contiguous batch of equal-length sequences.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     * 
+     * @tparam ParallelThreshold Split the batch across threads when it holds more points than this number per thread.
+     * @tparam It A contiguous iterator type with a std::complex underlying type.
+     * @param begin The batch begin iterator.
+     * @param end The batch end iterator.
+     * @param count The number of the sequences in the batch.
+     * @param order The layout of the batch.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 65536, std::contiguous_iterator It>
+        requires fft_compatible_iterator<It>
+    std::expected<void, std::string> fft2_batch(It begin, It end, size_t count, layout order = layout::contiguous)
+    {
+        using floating = typename std::iter_value_t<It>::value_type;
+        const size_t total = std::distance(begin, end);
+        if (count == 0 || total % count != 0)
+            return std::unexpected(std::format("The batch size={} is not a multiple of the count={}", total, count));
+
+        return detail::cached_plan<floating>(total / count, direction::forward)
+            .and_then([begin, end, order](const plan<floating>* p)
+            {
+                return fft2_batch<ParallelThreshold>(*p, begin, end, order);
+            });
+    }
+
+    /**
+     * @brief Performs IFFT of a contiguous batch of equal-length sequences.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     * 
+     * @tparam ParallelThreshold Split the batch across threads when it holds more points than this number per thread.
+     * @tparam It A contiguous iterator type with a std::complex underlying type.
+     * @param begin The batch begin iterator.
+     * @param end The batch end iterator.
+     * @param count The number of the sequences in the batch.
+     * @param order The layout of the batch.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <size_t ParallelThreshold = 65536, std::contiguous_iterator It>
+        requires fft_compatible_iterator<It>
+    std::expected<void, std::string> ifft2_batch(It begin, It end, size_t count, layout order = layout::contiguous)
+    {
+        using floating = typename std::iter_value_t<It>::value_type;
+        const size_t total = std::distance(begin, end);
+        if (count == 0 || total % count != 0)
+            return std::unexpected(std::format("The batch size={} is not a multiple of the count={}", total, count));
+
+        return detail::cached_plan<floating>(total / count, direction::inverse)
+            .and_then([begin, end, order](const plan<floating>* p)
+            {
+                return ifft2_batch<ParallelThreshold>(*p, begin, end, order);
+            });
+    }
+
+    /**
+     * @brief Performs FFT of the sequence in the split layout.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     * 
+     * @param x The sequence, transformed in place.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> fft2(utils::split_buffer<T>& x)
+    {
+        return detail::cached_plan<T>(x.size(), direction::forward)
+            .and_then([&x](const plan<T>* p)
+            {
+                return p->execute(x.real(), x.imag());
+            });
+    }
+
+    /**
+     * @brief Performs IFFT of the sequence in the split layout.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     * 
+     * @param x The sequence, transformed in place.
+     * @return std::expected<void, std::string> 
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> ifft2(utils::split_buffer<T>& x)
+    {
+        return detail::cached_plan<T>(x.size(), direction::inverse)
+            .and_then([&x](const plan<T>* p)
+            {
+                return p->execute(x.real(), x.imag());
+            })
+            .and_then([&x]() -> std::expected<void, std::string>
+            {
+                const T scale = T{1} / x.size();
+                for (auto& v: x.real())
+                    v *= scale;
+                for (auto& v: x.imag())
+                    v *= scale;
+                return {};
+            }); // monadic action on success: scaling down and resetting return to void
+    }
+}
+
+// The backends the runtime-size fft2/ifft2 route to, after the plans they are built on
+#include "fft_backend.hpp"
\ No newline at end of file
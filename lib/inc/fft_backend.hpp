@@ -0,0 +1,508 @@
+#pragma once
+
+#include "fft.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <concepts>
+#include <cstdlib>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(SDR_WITH_FFTW)
+#include <fftw3.h>
+#endif
+
+namespace fft
+{
+    /**
+     * @brief An implementation of the in-place FFT of contiguous sequences: the built-in plans of an
+     * instruction set, FFTW or anything registered by the user. Must be safe to execute concurrently.
+     *
+     * @tparam T double or float.
+     */
+    template <std::floating_point T>
+    class backend
+    {
+    public:
+        virtual ~backend() = default;
+
+        // A unique name, the key of the backend in the wisdom file
+        virtual std::string_view name() const noexcept = 0;
+
+        /**
+         * @brief Transforms the sequence in place.
+         *
+         * @param x The sequence.
+         * @param size The sequence size.
+         * @param dir Direction of the transform; the inverse one is non-scaled.
+         * @param parallel_threshold Split the work of a stage across threads in chunks of at least this number of points,
+         * a hint the backends running with their own threading may ignore.
+         * @return std::expected<void, std::string>
+         * - Nothing on success;
+         * - Error string on failure, e.g. the size is not supported.
+         */
+        virtual std::expected<void, std::string> execute(std::complex<T>* x, size_t size, direction dir,
+                                                         size_t parallel_threshold) const = 0;
+    };
+
+    namespace detail
+    {
+        // The key of the plans a thread remembers per backend: never reused, unlike the addresses,
+        // so a thread never meets a plan of a backend gone
+        inline uint64_t next_backend_id() noexcept
+        {
+            static std::atomic<uint64_t> id{0};
+            return id.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief The built-in plans of an instruction set, optionally forced to an algorithm.
+     * The plans are created on the first use of a size and shared by all the threads; every thread remembers
+     * the plans it has met, so that only its first use of a size takes the lock.
+     */
+    template <std::floating_point T>
+    class builtin_backend : public backend<T>
+    {
+    public:
+        using algorithm = typename plan<T>::algorithm;
+
+        explicit builtin_backend(simd::isa set, std::optional<algorithm> kind = std::nullopt)
+            : set_(set)
+            , kind_(kind)
+            , name_(std::format("builtin-{}", simd::name(set)))
+            , id_(detail::next_backend_id())
+        {
+            if (kind == algorithm::stockham)
+                name_ += "-stockham";
+            else if (kind == algorithm::four_step)
+                name_ += "-four-step";
+        }
+
+        std::string_view name() const noexcept override { return name_; }
+
+        std::expected<void, std::string> execute(std::complex<T>* x, size_t size, direction dir,
+                                                 size_t parallel_threshold) const override
+        {
+            return get(size, dir)
+                .and_then([x, size, parallel_threshold](const plan<T>* p)
+                {
+                    return p->execute(x, x + size, parallel_threshold);
+                });
+        }
+
+    private:
+        std::expected<const plan<T>*, std::string> get(size_t size, direction dir) const
+        {
+            thread_local std::unordered_map<uint64_t, std::unordered_map<size_t, const plan<T>*>> seen[2];
+
+            auto& known = seen[dir == direction::inverse][id_];
+            if (auto it = known.find(size); it != known.end())
+                return it->second;
+            return shared(size, dir)
+                .transform([&known, size](const plan<T>* p)
+                {
+                    return known[size] = p;
+                });
+        }
+
+        std::expected<const plan<T>*, std::string> shared(size_t size, direction dir) const
+        {
+            std::lock_guard lock(mutex_);
+            const auto key = std::make_pair(size, dir);
+            if (auto it = plans_.find(key); it != plans_.end())
+                return it->second.get();
+
+            return plan<T>::create(size, dir, set_, kind_)
+                .transform([this, key](plan<T>&& p) -> const plan<T>*
+                {
+                    return plans_.emplace(key, std::make_unique<const plan<T>>(std::move(p))).first->second.get();
+                });
+        }
+
+        simd::isa                                                                   set_;
+        std::optional<algorithm>                                                    kind_;
+        std::string                                                                 name_;
+        uint64_t                                                                    id_;
+        mutable std::mutex                                                          mutex_;
+        mutable std::map<std::pair<size_t, direction>, std::unique_ptr<const plan<T>>> plans_; // Never erased, the threads keep the pointers
+    };
+
+#if defined(SDR_WITH_FFTW)
+    namespace detail
+    {
+        template <typename T>
+        struct fftw;
+
+        template <>
+        struct fftw<double>
+        {
+            using plan_t = fftw_plan;
+            using complex = fftw_complex;
+
+            static plan_t create(int n, complex* x, int sign, unsigned flags) { return fftw_plan_dft_1d(n, x, x, sign, flags); }
+            static void execute(plan_t p, complex* x) { fftw_execute_dft(p, x, x); }
+            static void destroy(plan_t p) { fftw_destroy_plan(p); }
+            static complex* alloc(size_t n) { return fftw_alloc_complex(n); }
+            static void free(complex* x) { fftw_free(x); }
+        };
+
+        template <>
+        struct fftw<float>
+        {
+            using plan_t = fftwf_plan;
+            using complex = fftwf_complex;
+
+            static plan_t create(int n, complex* x, int sign, unsigned flags) { return fftwf_plan_dft_1d(n, x, x, sign, flags); }
+            static void execute(plan_t p, complex* x) { fftwf_execute_dft(p, x, x); }
+            static void destroy(plan_t p) { fftwf_destroy_plan(p); }
+            static complex* alloc(size_t n) { return fftwf_alloc_complex(n); }
+            static void free(complex* x) { fftwf_free(x); }
+        };
+    }
+
+    /**
+     * @brief FFTW3, enabled by the SDR_WITH_FFTW CMake option.
+     * The plans are measured on a scratch array at the first use of a size and executed on any array
+     * via the new-array interface. Only the execution of the FFTW plans is thread-safe, so the planning is serialized;
+     * every thread remembers the plans it has met, so that only its first use of a size takes the lock.
+     */
+    template <std::floating_point T>
+        requires std::same_as<T, double> || std::same_as<T, float>
+    class fftw_backend : public backend<T>
+    {
+        using api = detail::fftw<T>;
+
+    public:
+        fftw_backend() : id_(detail::next_backend_id()) {}
+        fftw_backend(const fftw_backend&) = delete;
+        fftw_backend& operator=(const fftw_backend&) = delete;
+
+        ~fftw_backend() override
+        {
+            for (auto& [key, p]: plans_)
+                api::destroy(p);
+        }
+
+        std::string_view name() const noexcept override { return "fftw"; }
+
+        // The threshold is ignored, the threads of FFTW being set up by the application with fftw_plan_with_nthreads()
+        std::expected<void, std::string> execute(std::complex<T>* x, size_t size, direction dir, size_t) const override
+        {
+            return get(size, dir)
+                .and_then([x](typename api::plan_t p) -> std::expected<void, std::string>
+                {
+                    api::execute(p, reinterpret_cast<typename api::complex*>(x)); // std::complex<T> is layout-compatible with T[2]
+                    return {};
+                });
+        }
+
+    private:
+        std::expected<typename api::plan_t, std::string> get(size_t size, direction dir) const
+        {
+            thread_local std::unordered_map<uint64_t, std::unordered_map<size_t, typename api::plan_t>> seen[2];
+
+            auto& known = seen[dir == direction::inverse][id_];
+            if (auto it = known.find(size); it != known.end())
+                return it->second;
+            return shared(size, dir)
+                .transform([&known, size](typename api::plan_t p)
+                {
+                    return known[size] = p;
+                });
+        }
+
+        std::expected<typename api::plan_t, std::string> shared(size_t size, direction dir) const
+        {
+            if (size == 0 || size > static_cast<size_t>(std::numeric_limits<int>::max()))
+                return std::unexpected(std::format("FFTW does not support the size={}", size));
+
+            std::lock_guard lock(mutex_);
+            const auto key = std::make_pair(size, dir);
+            if (auto it = plans_.find(key); it != plans_.end())
+                return it->second;
+
+            auto* scratch = api::alloc(size);
+            const auto p = api::create(static_cast<int>(size), scratch, dir == direction::inverse ? FFTW_BACKWARD : FFTW_FORWARD,
+                                       FFTW_MEASURE | FFTW_UNALIGNED);
+            api::free(scratch);
+            if (!p)
+                return std::unexpected(std::format("FFTW failed to plan the size={}", size));
+            return plans_.emplace(key, p).first->second;
+        }
+
+        uint64_t                                                                    id_;
+        mutable std::mutex                                                          mutex_;
+        mutable std::map<std::pair<size_t, direction>, typename api::plan_t>        plans_; // Never erased, the threads keep the plans
+    };
+#endif
+
+    /**
+     * @brief The backends of the FFT of T and the choice of the fastest one per size and direction.
+     * The choice is made by timing every backend at the first use of a size (the autotuning), or taken
+     * from the wisdom file of the previous runs. fft2/ifft2 of the contiguous sequences are routed here.
+     *
+     * Registered at startup: the built-in plans of every instruction set supported by the CPU,
+     * the built-in Stockham plans of the widest one and FFTW if built with SDR_WITH_FFTW.
+     * If the SDR_FFT_WISDOM environment variable names a file, the wisdom is loaded from it at startup
+     * and saved to it after every autotuning.
+     *
+     * Every thread remembers the backends it has been given, so the transforms of a size tuned already take no lock;
+     * any change of the backends or of the wisdom bumps a generation, which makes the threads ask again.
+     *
+     * @tparam T double or float.
+     */
+    template <std::floating_point T>
+    class registry
+    {
+    public:
+        static registry& instance()
+        {
+            static registry r;
+            return r;
+        }
+
+        /**
+         * @brief Registers a backend; it takes part in the autotuning of the sizes not tuned yet.
+         */
+        void add(std::shared_ptr<const backend<T>> b)
+        {
+            std::lock_guard lock(mutex_);
+            backends_.push_back(std::move(b));
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Unregisters the backend of the name and forgets the wisdom routing to it.
+         */
+        void remove(std::string_view name)
+        {
+            std::lock_guard lock(mutex_);
+            std::erase_if(backends_, [name](const auto& b) { return b->name() == name; });
+            std::erase_if(wisdom_, [name](const auto& entry) { return entry.second == name; });
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+
+        std::vector<std::shared_ptr<const backend<T>>> backends() const
+        {
+            std::lock_guard lock(mutex_);
+            return backends_;
+        }
+
+        /**
+         * @brief Enables or disables the autotuning. When disabled, the sizes with no wisdom go to the first backend.
+         */
+        void autotune(bool on)
+        {
+            std::lock_guard lock(mutex_);
+            autotune_ = on;
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Provides the fastest backend for the size and direction, autotuning on the first use.
+         */
+        const backend<T>& select(size_t size, direction dir)
+        {
+            struct choice
+            {
+                uint64_t                            generation = 0;
+                std::shared_ptr<const backend<T>>   chosen;     // Keeps the backend alive while the thread uses it
+            };
+            thread_local std::unordered_map<size_t, choice> choices[2];
+
+            auto& c = choices[dir == direction::inverse][size];
+            const uint64_t generation = generation_.load(std::memory_order_acquire);
+            if (!c.chosen || c.generation != generation)
+                c = { generation, resolve(size, dir) };
+            return *c.chosen;
+        }
+
+        /**
+         * @brief Loads the choices of the previous runs. The entries of the backends not registered here are kept,
+         * but ignored until such a backend is registered.
+         *
+         * @param path The wisdom file; lines of "<float|double> <size> <forward|inverse> <backend name>".
+         * @return std::expected<void, std::string>
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        std::expected<void, std::string> load_wisdom(const std::string& path)
+        {
+            std::ifstream in(path);
+            if (!in)
+                return std::unexpected(std::format("Cannot open the wisdom file {}", path));
+
+            std::lock_guard lock(mutex_);
+            std::string line;
+            while (std::getline(in, line))
+            {
+                std::istringstream fields(line);
+                std::string type, dir, name;
+                size_t size = 0;
+                if (!(fields >> type >> size >> dir >> name) || (dir != "forward" && dir != "inverse"))
+                    return std::unexpected(std::format("Malformed line of the wisdom file {}: {}", path, line));
+                if (type == precision())
+                    wisdom_[{size, dir == "inverse" ? direction::inverse : direction::forward}] = name;
+            }
+            generation_.fetch_add(1, std::memory_order_release);
+            return {};
+        }
+
+        /**
+         * @brief Saves the choices made so far, keeping the entries of the other precisions in the file.
+         */
+        std::expected<void, std::string> save_wisdom(const std::string& path) const
+        {
+            std::unique_lock lock(mutex_);
+            const auto wisdom = wisdom_;
+            lock.unlock();
+            return save(path, wisdom);
+        }
+
+    private:
+        registry()
+        {
+            for (auto set: {simd::isa::avx512, simd::isa::avx2, simd::isa::scalar}) // The widest first, the default without autotuning
+                if (simd::supported(set))
+                    backends_.push_back(std::make_shared<const builtin_backend<T>>(set));
+            backends_.push_back(std::make_shared<const builtin_backend<T>>(simd::detect(), plan<T>::algorithm::stockham));
+#if defined(SDR_WITH_FFTW)
+            if constexpr (std::same_as<T, double> || std::same_as<T, float>)
+                backends_.push_back(std::make_shared<const fftw_backend<T>>());
+#endif
+            if (const char* path = std::getenv("SDR_FFT_WISDOM"))
+            {
+                path_ = path;
+                (void)load_wisdom(path_); // No wisdom yet on the first run
+            }
+        }
+
+        static constexpr std::string_view precision()
+        {
+            return std::same_as<T, float> ? "float" : std::same_as<T, double> ? "double" : "long-double";
+        }
+
+        std::shared_ptr<const backend<T>> find(std::string_view name) const
+        {
+            for (const auto& b: backends_)
+                if (b->name() == name)
+                    return b;
+            return nullptr;
+        }
+
+        // The choice of the wisdom or of the autotuning, the file being written with no lock held
+        std::shared_ptr<const backend<T>> resolve(size_t size, direction dir)
+        {
+            {
+                std::lock_guard lock(mutex_);
+                if (auto it = wisdom_.find({size, dir}); it != wisdom_.end())
+                {
+                    if (auto b = find(it->second))
+                        return b;
+                }
+                if (!autotune_ || backends_.size() == 1 || size == 0)
+                    return backends_.front();
+            }
+
+            const std::string fastest = tune(size, dir);
+            std::unique_lock lock(mutex_);
+            wisdom_[{size, dir}] = fastest;
+            auto chosen = find(fastest);
+            if (!chosen) // Removed while tuning
+                chosen = backends_.front();
+            if (!path_.empty())
+            {
+                const auto wisdom = wisdom_;
+                lock.unlock();
+                (void)save(path_, wisdom);
+            }
+            return chosen;
+        }
+
+        // Times every backend on a test sequence, the best of a few trials, with the parallel threshold of fft2
+        std::string tune(size_t size, direction dir) const
+        {
+            constexpr size_t parallel_threshold = 1024;
+            using clock = std::chrono::steady_clock;
+
+            std::vector<std::complex<T>> ref(size), work(size);
+            for (size_t n = 0; n < size; ++n)
+                ref[n] = { static_cast<T>(n % 7) - 3, static_cast<T>(n % 5) - 2 };
+            const size_t reps = std::max<size_t>(1, (size_t{1} << 16) / size);
+
+            std::string fastest;
+            auto best = clock::duration::max();
+            for (const auto& b: backends())
+            {
+                work = ref;
+                if (!b->execute(work.data(), size, dir, parallel_threshold)) // Also creates the plans before the timing
+                    continue;
+
+                auto elapsed = clock::duration::max();
+                for (int trial = 0; trial < 3; ++trial)
+                {
+                    const auto start = clock::now();
+                    for (size_t r = 0; r < reps; ++r)
+                    {
+                        std::copy(ref.begin(), ref.end(), work.begin()); // Keeps the values bounded
+                        (void)b->execute(work.data(), size, dir, parallel_threshold);
+                    }
+                    elapsed = std::min(elapsed, clock::now() - start);
+                }
+                if (elapsed < best)
+                {
+                    best = elapsed;
+                    fastest = b->name();
+                }
+            }
+            return fastest.empty() ? std::string(backends().front()->name()) : fastest;
+        }
+
+        // Writes the wisdom, one writer of the file at a time
+        std::expected<void, std::string> save(const std::string& path, const std::map<std::pair<size_t, direction>, std::string>& wisdom) const
+        {
+            std::lock_guard lock(file_mutex_);
+            std::vector<std::string> others;
+            {
+                std::ifstream in(path);
+                std::string line;
+                while (std::getline(in, line))
+                    if (!line.starts_with(precision()) || line[precision().size()] != ' ')
+                        others.push_back(line);
+            }
+
+            std::ofstream out(path, std::ios::trunc);
+            if (!out)
+                return std::unexpected(std::format("Cannot write the wisdom file {}", path));
+            for (const auto& line: others)
+                out << line << '\n';
+            for (const auto& [key, name]: wisdom)
+                out << precision() << ' ' << key.first << ' ' << (key.second == direction::inverse ? "inverse" : "forward") << ' ' << name << '\n';
+            return {};
+        }
+
+        mutable std::mutex                                  mutex_;
+        mutable std::mutex                                  file_mutex_;
+        std::atomic<uint64_t>                               generation_{1};
+        std::vector<std::shared_ptr<const backend<T>>>      backends_;
+        std::map<std::pair<size_t, direction>, std::string> wisdom_; // The fastest backend name per size and direction
+        bool                                                autotune_ = true;
+        std::string                                         path_;   // The wisdom file of SDR_FFT_WISDOM
+    };
+}
\ No newline at end of file
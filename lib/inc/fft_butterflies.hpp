@@ -0,0 +1,305 @@
+// No include guard on purpose: fft_kernels.hpp includes this body once per instruction set,
+// inside the namespace and the target region of that instruction set.
+//
+// The kernels are written against a vector trait V providing
+// - reg, a register of V::lanes interleaved complex numbers;
+// - load/store of a register from/to interleaved (re, im) data, bcast of one complex number to all lanes;
+// - add/sub of registers and cmul, the complex multiplication of registers.
+// The split-layout kernels are written against a trait R of real registers of R::lanes values
+// providing load/store, add/sub/mul and the fused fmadd(a, b, c) = a*b + c, fmsub(a, b, c) = a*b - c.
+
+/**
+ * @brief A radix-2 Decimation-In-Time stage combining the blocks of h points into the blocks of 2h points.
+ *
+ * @tparam V A vector trait, V::lanes must divide h.
+ * @param x Interleaved data, a power of 2 complex numbers, in the bit-reversed order for the first stage.
+ * @param size The number of complex numbers.
+ * @param h The half-size of the blocks of the stage.
+ * @param w Interleaved twiddles of the stage: (w(2h)^0, ..., w(2h)^(h - 1)).
+ */
+template <typename V, typename T>
+void radix2_stage(T* x, size_t size, size_t h, const T* w)
+{
+    for (size_t i = 0; i < size; i += 2 * h)
+    {
+        for (size_t j = 0; j < h; j += V::lanes)
+        {
+            T* a = x + 2 * (i + j);
+            T* b = a + 2 * h;
+
+            const auto even = V::load(a);
+            const auto t    = V::cmul(V::load(b), V::load(w + 2 * j));
+            V::store(a, V::add(even, t));
+            V::store(b, V::sub(even, t));
+        }
+    }
+}
+
+/**
+ * @brief Two consecutive radix-2 stages fused into a radix-4 pass, combining the blocks of h points
+ * into the blocks of 4h points. Each point is loaded and stored once per the two stages.
+ *
+ * @tparam V A vector trait, V::lanes must divide h.
+ * @param x Interleaved data, a power of 2 complex numbers.
+ * @param size The number of complex numbers.
+ * @param h The half-size of the blocks of the first stage.
+ * @param w1 Interleaved twiddles of the first stage: (w(2h)^0, ..., w(2h)^(h - 1)).
+ * @param w2 Interleaved twiddles of the second stage: (w(4h)^0, ..., w(4h)^(2h - 1)).
+ */
+template <typename V, typename T>
+void radix4_stage(T* x, size_t size, size_t h, const T* w1, const T* w2)
+{
+    for (size_t i = 0; i < size; i += 4 * h)
+    {
+        for (size_t j = 0; j < h; j += V::lanes)
+        {
+            T* p0 = x + 2 * (i + j);
+            T* p1 = p0 + 2 * h;
+            T* p2 = p1 + 2 * h;
+            T* p3 = p2 + 2 * h;
+
+            // The first stage: (p0, p1) and (p2, p3) share the twiddle
+            const auto wa = V::load(w1 + 2 * j);
+            const auto x0 = V::load(p0);
+            const auto x1 = V::cmul(V::load(p1), wa);
+            const auto x2 = V::load(p2);
+            const auto x3 = V::cmul(V::load(p3), wa);
+
+            const auto a0 = V::add(x0, x1);
+            const auto a1 = V::sub(x0, x1);
+            const auto a2 = V::cmul(V::add(x2, x3), V::load(w2 + 2 * j));
+            const auto a3 = V::cmul(V::sub(x2, x3), V::load(w2 + 2 * (j + h)));
+
+            // The second stage: (p0, p2) and (p1, p3)
+            V::store(p0, V::add(a0, a2));
+            V::store(p2, V::sub(a0, a2));
+            V::store(p1, V::add(a1, a3));
+            V::store(p3, V::sub(a1, a3));
+        }
+    }
+}
+
+/**
+ * @brief Runs the stages from the blocks of h points up to the whole sequence, radix-4 while possible.
+ *
+ * @param x Interleaved data, a power of 2 complex numbers.
+ * @param size The number of complex numbers.
+ * @param h The half-size of the blocks of the first stage to run, V::lanes must divide it.
+ * @param twiddles Interleaved stage-wise twiddle tables: the stage of N = 2h points starts at twiddles[2 * (h - 1)].
+ */
+template <typename V, typename T>
+void stages(T* x, size_t size, size_t h, const T* twiddles)
+{
+    for (; 4 * h <= size; h *= 4)
+        radix4_stage<V>(x, size, h, twiddles + 2 * (h - 1), twiddles + 2 * (2 * h - 1));
+    if (2 * h <= size)
+        radix2_stage<V>(x, size, h, twiddles + 2 * (h - 1));
+}
+
+/**
+ * @brief An out-of-place radix-2 Stockham autosort stage (Decimation-In-Frequency): splits the s interleaved
+ * sub-transforms of n = size / s points into 2s ones of n / 2 points. The output is written in the order
+ * the next stage reads it, so that the last stage leaves the spectrum in the natural order with no bit reversal.
+ * The points of all the sub-transforms at a position share the twiddle, hence the butterflies are
+ * vectorized across the sub-transforms.
+ *
+ * @tparam V A vector trait, V::lanes must divide s.
+ * @param x Interleaved input: the point p of the sub-transform q is at p * s + q.
+ * @param y Interleaved output, must not overlap x.
+ * @param size The number of complex numbers, a power of 2.
+ * @param s The number of the sub-transforms.
+ * @param w Interleaved twiddles of n points: (w(n)^0, ..., w(n)^(n / 2 - 1)).
+ */
+template <typename V, typename T>
+void stockham_stage(const T* x, T* y, size_t size, size_t s, const T* w)
+{
+    const size_t m = size / (2 * s);
+    for (size_t p = 0; p < m; ++p)
+    {
+        const auto wp = V::bcast(w + 2 * p);
+        const T*   a  = x + 2 * s * p;
+        const T*   b  = a + 2 * s * m;
+        T*         c  = y + 4 * s * p;
+        T*         d  = c + 2 * s;
+        for (size_t q = 0; q < s; q += V::lanes)
+        {
+            const auto u = V::load(a + 2 * q);
+            const auto v = V::load(b + 2 * q);
+            V::store(c + 2 * q, V::add(u, v));
+            V::store(d + 2 * q, V::cmul(V::sub(u, v), wp));
+        }
+    }
+}
+
+/**
+ * @brief Two Stockham stages fused into a radix-4 pass: splits the s interleaved sub-transforms of n = size / s
+ * points into 4s ones of n / 4 points, see stockham_stage. Each point is loaded and stored once per the two stages.
+ *
+ * @tparam V A vector trait, V::lanes must divide s.
+ * @param x Interleaved input: the point p of the sub-transform q is at p * s + q.
+ * @param y Interleaved output, must not overlap x.
+ * @param size The number of complex numbers, a power of 2.
+ * @param s The number of the sub-transforms, n >= 4.
+ * @param w Interleaved twiddles of n points: (w(n)^0, ..., w(n)^(n / 2 - 1)).
+ * @param rot Interleaved w(4)^1, i.e. -i for FFT and +i for IFFT.
+ */
+template <typename V, typename T>
+void stockham_radix4_stage(const T* x, T* y, size_t size, size_t s, const T* w, const T* rot)
+{
+    const size_t m = size / (4 * s);
+    const auto   j = V::bcast(rot);
+    for (size_t p = 0; p < m; ++p)
+    {
+        const auto w1 = V::bcast(w + 2 * p);
+        const auto w2 = V::bcast(w + 4 * p);
+        const auto w3 = V::cmul(w1, w2);
+        const T*   a  = x + 2 * s * p;
+        T*         c  = y + 8 * s * p;
+        for (size_t q = 0; q < s; q += V::lanes)
+        {
+            const auto a0 = V::load(a + 2 * q);
+            const auto a1 = V::load(a + 2 * (q + s * m));
+            const auto a2 = V::load(a + 2 * (q + 2 * s * m));
+            const auto a3 = V::load(a + 2 * (q + 3 * s * m));
+
+            const auto b0 = V::add(a0, a2);
+            const auto b1 = V::sub(a0, a2);
+            const auto b2 = V::add(a1, a3);
+            const auto b3 = V::cmul(V::sub(a1, a3), j);
+
+            V::store(c + 2 * q,           V::add(b0, b2));
+            V::store(c + 2 * (q + s),     V::cmul(V::add(b1, b3), w1));
+            V::store(c + 2 * (q + 2 * s), V::cmul(V::sub(b0, b2), w2));
+            V::store(c + 2 * (q + 3 * s), V::cmul(V::sub(b1, b3), w3));
+        }
+    }
+}
+
+/**
+ * @brief A radix-2 Decimation-In-Time stage of a batch of transforms in the interleaved layout,
+ * i.e. the point n of the transform k is at n * stride + k. All the transforms of a row share the twiddle,
+ * so the butterflies are vectorized across the transforms.
+ *
+ * @param x Interleaved data of the batch, rows of a power of 2 points.
+ * @param size The number of rows, i.e. the transform size.
+ * @param h The half-size of the blocks of the stage.
+ * @param stride The distance between the rows in complex numbers.
+ * @param cols The number of transforms of a row to process.
+ * @param w Interleaved twiddles of the stage: (w(2h)^0, ..., w(2h)^(h - 1)).
+ */
+template <typename V, typename T>
+void rows_radix2_stage(T* x, size_t size, size_t h, size_t stride, size_t cols, const T* w)
+{
+    for (size_t i = 0; i < size; i += 2 * h)
+    {
+        for (size_t j = 0; j < h; ++j)
+        {
+            T* a = x + 2 * (i + j) * stride;
+            T* b = a + 2 * h * stride;
+
+            const auto wv = V::bcast(w + 2 * j);
+            size_t k = 0;
+            for (; k + V::lanes <= cols; k += V::lanes)
+            {
+                const auto even = V::load(a + 2 * k);
+                const auto t    = V::cmul(V::load(b + 2 * k), wv);
+                V::store(a + 2 * k, V::add(even, t));
+                V::store(b + 2 * k, V::sub(even, t));
+            }
+            for (; k < cols; ++k) // The tail narrower than a register
+            {
+                const T tr = b[2 * k] * w[2 * j] - b[2 * k + 1] * w[2 * j + 1];
+                const T ti = b[2 * k] * w[2 * j + 1] + b[2 * k + 1] * w[2 * j];
+                b[2 * k]     = a[2 * k] - tr;
+                b[2 * k + 1] = a[2 * k + 1] - ti;
+                a[2 * k]     += tr;
+                a[2 * k + 1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs all the stages of a batch of transforms in the interleaved layout, see rows_radix2_stage.
+ */
+template <typename V, typename T>
+void rows_stages(T* x, size_t size, size_t stride, size_t cols, const T* twiddles)
+{
+    for (size_t h = 1; 2 * h <= size; h *= 2)
+        rows_radix2_stage<V>(x, size, h, stride, cols, twiddles + 2 * (h - 1));
+}
+
+/**
+ * @brief Pointwise complex multiplication x[i] *= y[i], e.g. of two spectra.
+ *
+ * @param x Interleaved data, n complex numbers.
+ * @param y Interleaved data, n complex numbers.
+ * @param n The number of complex numbers.
+ */
+template <typename V, typename T>
+void multiply(T* x, const T* y, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes)
+        V::store(x + 2 * i, V::cmul(V::load(x + 2 * i), V::load(y + 2 * i)));
+    for (; i < n; ++i) // The tail narrower than a register
+    {
+        const T re = x[2 * i] * y[2 * i] - x[2 * i + 1] * y[2 * i + 1];
+        const T im = x[2 * i] * y[2 * i + 1] + x[2 * i + 1] * y[2 * i];
+        x[2 * i]     = re;
+        x[2 * i + 1] = im;
+    }
+}
+
+/**
+ * @brief A radix-2 Decimation-In-Time stage over the split layout, see radix2_stage.
+ * Each lane holds the same component of a different point, so the complex multiplication
+ * is four real multiplications folded into two fused operations with no shuffles.
+ *
+ * @tparam R A real register trait, R::lanes must divide h.
+ * @param re The real parts, a power of 2 values.
+ * @param im The imaginary parts.
+ * @param size The number of complex numbers.
+ * @param h The half-size of the blocks of the stage.
+ * @param wr The real parts of the stage twiddles: (w(2h)^0, ..., w(2h)^(h - 1)).
+ * @param wi The imaginary parts of the stage twiddles.
+ */
+template <typename R, typename T>
+void split_radix2_stage(T* re, T* im, size_t size, size_t h, const T* wr, const T* wi)
+{
+    for (size_t i = 0; i < size; i += 2 * h)
+    {
+        for (size_t j = 0; j < h; j += R::lanes)
+        {
+            const size_t a = i + j;
+            const size_t b = a + h;
+
+            const auto br = R::load(re + b);
+            const auto bi = R::load(im + b);
+            const auto cr = R::load(wr + j);
+            const auto ci = R::load(wi + j);
+            const auto tr = R::fmsub(br, cr, R::mul(bi, ci));
+            const auto ti = R::fmadd(br, ci, R::mul(bi, cr));
+
+            const auto ar = R::load(re + a);
+            const auto ai = R::load(im + a);
+            R::store(re + a, R::add(ar, tr));
+            R::store(im + a, R::add(ai, ti));
+            R::store(re + b, R::sub(ar, tr));
+            R::store(im + b, R::sub(ai, ti));
+        }
+    }
+}
+
+/**
+ * @brief Runs the split-layout stages from the blocks of h points up to the whole sequence.
+ *
+ * @param twiddles_re The real parts of the stage-wise twiddle tables: the stage of N = 2h points starts at [h - 1].
+ * @param twiddles_im The imaginary parts, laid out the same way.
+ */
+template <typename R, typename T>
+void split_stages(T* re, T* im, size_t size, size_t h, const T* twiddles_re, const T* twiddles_im)
+{
+    for (; 2 * h <= size; h *= 2)
+        split_radix2_stage<R>(re, im, size, h, twiddles_re + h - 1, twiddles_im + h - 1);
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <complex>
+#include <concepts>
+#include <iterator>
+#include <numbers>
+#include <utility>
+
+namespace fft::detail::codelet
+{
+    /**
+     * The smallest and the largest power of 2 sizes served by the codelets
+     */
+    inline constexpr size_t min_size = 2;
+    inline constexpr size_t max_size = 256;
+
+    /**
+     * The largest size the runtime-size API forwards to the codelets. Beyond it the unrolled code outgrows
+     * the instruction cache and the vector kernels of a plan win: 1.1-2.5x faster up to 16 points,
+     * about as fast at 32 and 3-6x slower at 256 on AVX2/AVX-512 machines.
+     */
+    inline constexpr size_t forward_size = 16;
+
+    /**
+     * @brief w(N)^k evaluated at compile time in extended precision.
+     * The angle is reduced to [-pi, pi] first, where the Taylor series converge fast.
+     */
+    template <std::floating_point T>
+    constexpr std::complex<T> root(size_t k, size_t N, bool inverse)
+    {
+        k %= N;
+        const long double pi = std::numbers::pi_v<long double>;
+        const long double turns = 2 * k > N ? static_cast<long double>(k) - N : static_cast<long double>(k);
+        long double theta = 2.0L * pi * turns / N;
+        if (!inverse)
+            theta = -theta;
+
+        long double c = 0, s = 0, term = 1; // term = theta^n / n!
+        for (size_t n = 0; n < 40; ++n)
+        {
+            switch (n % 4)
+            {
+            case 0: c += term; break;
+            case 1: s += term; break;
+            case 2: c -= term; break;
+            case 3: s -= term; break;
+            }
+            term *= theta / (n + 1);
+        }
+        return { static_cast<T>(c), static_cast<T>(s) };
+    }
+
+    template <std::floating_point T, size_t N, bool Inverse>
+    constexpr std::array<std::complex<T>, N / 2> roots()
+    {
+        std::array<std::complex<T>, N / 2> w{};
+        for (size_t k = 0; k < w.size(); ++k)
+            w[k] = root<T>(k, N, Inverse);
+        return w;
+    }
+
+    // The roots of the whole transform, every stage uses a strided subset of them
+    template <std::floating_point T, size_t N, bool Inverse>
+    inline constexpr auto roots_v = roots<T, N, Inverse>();
+
+    constexpr size_t reverse_bits(size_t i, size_t N)
+    {
+        size_t r = 0;
+        for (size_t bit = 1; bit < N; bit <<= 1, i >>= 1)
+            r = (r << 1) | (i & 1);
+        return r;
+    }
+
+    template <size_t I, size_t N>
+    inline constexpr size_t reverse_bits_v = reverse_bits(I, N);
+
+    /**
+     * @brief The butterfly B of the DIT stage combining the blocks of H points. Every index and the twiddle
+     * are compile-time constants; the trivial twiddles 1 and -+i cost no multiplication.
+     */
+    template <size_t N, size_t H, size_t B, bool Inverse, std::floating_point T>
+    [[gnu::always_inline]] inline void butterfly(T* re, T* im)
+    {
+        constexpr size_t j = B % H;
+        constexpr size_t a = (B / H) * 2 * H + j;
+        constexpr size_t b = a + H;
+        constexpr size_t k = j * (N / (2 * H)); // The twiddle is w(N)^k
+
+        T tr, ti;
+        if constexpr (k == 0)
+        {
+            tr = re[b];
+            ti = im[b];
+        }
+        else if constexpr (4 * k == N)
+        {
+            tr = Inverse ? -im[b] : im[b];
+            ti = Inverse ? re[b] : -re[b];
+        }
+        else
+        {
+            constexpr std::complex<T> w = roots_v<T, N, Inverse>[k];
+            tr = re[b] * w.real() - im[b] * w.imag();
+            ti = re[b] * w.imag() + im[b] * w.real();
+        }
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+    }
+
+    template <size_t N, size_t H, bool Inverse, std::floating_point T, size_t... B>
+    [[gnu::always_inline]] inline void stage(T* re, T* im, std::index_sequence<B...>)
+    {
+        (butterfly<N, H, B, Inverse>(re, im), ...);
+    }
+
+    template <size_t N, size_t H, bool Inverse, std::floating_point T>
+    [[gnu::always_inline]] inline void stages(T* re, T* im)
+    {
+        if constexpr (2 * H <= N)
+        {
+            stage<N, H, Inverse>(re, im, std::make_index_sequence<N / 2>{});
+            stages<N, 2 * H, Inverse>(re, im);
+        }
+    }
+
+    /**
+     * @brief The radix-2 DIT FFT of N points as straight-line code: the bit reversal is folded into
+     * the loads, the stages are unrolled butterfly by butterfly and the scaling is folded into the stores.
+     *
+     * @tparam N The transform size, a power of 2.
+     * @tparam Inverse true for IFFT, false for FFT.
+     * @tparam Scaled true to scale the result by 1/N.
+     * @param begin A sequence begin iterator.
+     */
+    template <size_t N, bool Inverse, bool Scaled, std::random_access_iterator It, size_t... I>
+    void transform(It begin, std::index_sequence<I...>)
+    {
+        using floating = typename std::iter_value_t<It>::value_type;
+
+        floating re[N], im[N];
+        ((re[I] = (*(begin + reverse_bits_v<I, N>)).real(), im[I] = (*(begin + reverse_bits_v<I, N>)).imag()), ...);
+        stages<N, 1, Inverse>(re, im);
+        if constexpr (Scaled)
+        {
+            constexpr floating scale = floating{1} / N;
+            ((*(begin + I) = std::iter_value_t<It>{ re[I] * scale, im[I] * scale }), ...);
+        }
+        else
+            ((*(begin + I) = std::iter_value_t<It>{ re[I], im[I] }), ...);
+    }
+
+    template <size_t N, bool Inverse, bool Scaled, std::random_access_iterator It>
+    void transform(It begin)
+    {
+        transform<N, Inverse, Scaled>(begin, std::make_index_sequence<N>{});
+    }
+
+    /**
+     * @brief Runs the codelet of the given size if it is worth it, i.e. up to forward_size.
+     *
+     * @return true if the sequence has been transformed, false if the size is left to a plan.
+     */
+    template <bool Inverse, bool Scaled, std::random_access_iterator It>
+    bool dispatch(It begin, size_t size)
+    {
+        static_assert(forward_size == 16, "The cases must cover the forwarded sizes");
+        switch (size)
+        {
+        case 2:  transform<2, Inverse, Scaled>(begin);  return true;
+        case 4:  transform<4, Inverse, Scaled>(begin);  return true;
+        case 8:  transform<8, Inverse, Scaled>(begin);  return true;
+        case 16: transform<16, Inverse, Scaled>(begin); return true;
+        default: return false;
+        }
+    }
+}
\ No newline at end of file
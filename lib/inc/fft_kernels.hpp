@@ -0,0 +1,475 @@
+#pragma once
+
+#include "simd.hpp"
+#include <stdint.h>
+#include <complex>
+#include <concepts>
+#include <algorithm>
+#include <utility>
+
+#if SDR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace fft::detail
+{
+    namespace scalar
+    {
+        /**
+         * A vector trait of a single complex number, the reference for the vector ones.
+         */
+        template <std::floating_point T>
+        struct vec
+        {
+            using reg = std::complex<T>;
+            static constexpr size_t lanes = 1;
+
+            static reg load(const T* p) { return { p[0], p[1] }; }
+            static reg bcast(const T* p) { return { p[0], p[1] }; }
+            static void store(T* p, reg a) { p[0] = a.real(); p[1] = a.imag(); }
+            static reg add(reg a, reg b) { return { a.real() + b.real(), a.imag() + b.imag() }; }
+            static reg sub(reg a, reg b) { return { a.real() - b.real(), a.imag() - b.imag() }; }
+            static reg cmul(reg x, reg w)
+            {
+                return
+                {
+                    x.real() * w.real() - x.imag() * w.imag(),
+                    x.real() * w.imag() + x.imag() * w.real()
+                };
+            }
+        };
+
+        /**
+         * A real register trait of a single value, the reference for the vector ones.
+         */
+        template <std::floating_point T>
+        struct rvec
+        {
+            using reg = T;
+            static constexpr size_t lanes = 1;
+
+            static reg load(const T* p) { return *p; }
+            static void store(T* p, reg a) { *p = a; }
+            static reg add(reg a, reg b) { return a + b; }
+            static reg sub(reg a, reg b) { return a - b; }
+            static reg mul(reg a, reg b) { return a * b; }
+            static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+            static reg fmsub(reg a, reg b, reg c) { return a * b - c; }
+        };
+
+        #include "fft_butterflies.hpp"
+
+        /**
+         * @brief The first two stages fused: blocks of 4 points in the bit-reversed order,
+         * where the twiddles are trivial (1 and -i or +i).
+         *
+         * @param x Interleaved data, a power of 2 (>= 4) complex numbers.
+         * @param size The number of complex numbers.
+         * @param inverse true for the IFFT rotation (+i), false for the FFT one (-i).
+         */
+        template <std::floating_point T>
+        void radix4_first_stage(T* x, size_t size, bool inverse)
+        {
+            const T s = inverse ? T{1} : T{-1};
+            for (size_t i = 0; i < 2 * size; i += 8)
+            {
+                T* p = x + i;
+                const T a0r = p[0] + p[2], a0i = p[1] + p[3];
+                const T a1r = p[0] - p[2], a1i = p[1] - p[3];
+                const T a2r = p[4] + p[6], a2i = p[5] + p[7];
+                const T a3r = p[4] - p[6], a3i = p[5] - p[7];
+                const T tr  = -s * a3i, ti = s * a3r; // a3 rotated by +-i
+
+                p[0] = a0r + a2r; p[1] = a0i + a2i;
+                p[4] = a0r - a2r; p[5] = a0i - a2i;
+                p[2] = a1r + tr;  p[3] = a1i + ti;
+                p[6] = a1r - tr;  p[7] = a1i - ti;
+            }
+        }
+    }
+
+#if SDR_SIMD_X86
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+    namespace avx2
+    {
+        template <std::floating_point T>
+        struct vec;
+
+        template <>
+        struct vec<double>
+        {
+            using reg = __m256d;
+            static constexpr size_t lanes = 2;
+
+            static reg load(const double* p) { return _mm256_loadu_pd(p); }
+            static reg bcast(const double* p) { return _mm256_broadcast_pd(reinterpret_cast<const __m128d*>(p)); }
+            static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+            static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+            static reg cmul(reg x, reg w)
+            {
+                const reg wr = _mm256_movedup_pd(w);        // (wr, wr)
+                const reg wi = _mm256_permute_pd(w, 0xF);   // (wi, wi)
+                const reg xs = _mm256_permute_pd(x, 0x5);   // (xi, xr)
+                return _mm256_fmaddsub_pd(x, wr, _mm256_mul_pd(xs, wi)); // (xr*wr - xi*wi, xi*wr + xr*wi)
+            }
+        };
+
+        template <>
+        struct vec<float>
+        {
+            using reg = __m256;
+            static constexpr size_t lanes = 4;
+
+            static reg load(const float* p) { return _mm256_loadu_ps(p); }
+            static reg bcast(const float* p) { return _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double*>(p))); }
+            static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+            static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static reg cmul(reg x, reg w)
+            {
+                const reg wr = _mm256_moveldup_ps(w);
+                const reg wi = _mm256_movehdup_ps(w);
+                const reg xs = _mm256_permute_ps(x, 0xB1);
+                return _mm256_fmaddsub_ps(x, wr, _mm256_mul_ps(xs, wi));
+            }
+        };
+
+        template <std::floating_point T>
+        struct rvec;
+
+        template <>
+        struct rvec<double>
+        {
+            using reg = __m256d;
+            static constexpr size_t lanes = 4;
+
+            static reg load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+            static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+            static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_pd(a, b, c); }
+        };
+
+        template <>
+        struct rvec<float>
+        {
+            using reg = __m256;
+            static constexpr size_t lanes = 8;
+
+            static reg load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+            static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+            static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_ps(a, b, c); }
+        };
+
+        #include "fft_butterflies.hpp"
+    }
+    #pragma GCC pop_options
+
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx2,fma")
+    namespace avx512
+    {
+        template <std::floating_point T>
+        struct vec;
+
+        template <>
+        struct vec<double>
+        {
+            using reg = __m512d;
+            static constexpr size_t lanes = 4;
+
+            static reg load(const double* p) { return _mm512_loadu_pd(p); }
+            static reg bcast(const double* p) { return _mm512_broadcast_f64x4(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(p))); }
+            static void store(double* p, reg a) { _mm512_storeu_pd(p, a); }
+            static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+            static reg cmul(reg x, reg w)
+            {
+                const reg wr = _mm512_movedup_pd(w);
+                const reg wi = _mm512_permute_pd(w, 0xFF);
+                const reg xs = _mm512_permute_pd(x, 0x55);
+                return _mm512_fmaddsub_pd(x, wr, _mm512_mul_pd(xs, wi));
+            }
+        };
+
+        template <>
+        struct vec<float>
+        {
+            using reg = __m512;
+            static constexpr size_t lanes = 8;
+
+            static reg load(const float* p) { return _mm512_loadu_ps(p); }
+            static reg bcast(const float* p) { return _mm512_castpd_ps(_mm512_broadcastsd_pd(_mm_load_sd(reinterpret_cast<const double*>(p)))); }
+            static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+            static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+            static reg cmul(reg x, reg w)
+            {
+                const reg wr = _mm512_moveldup_ps(w);
+                const reg wi = _mm512_movehdup_ps(w);
+                const reg xs = _mm512_permute_ps(x, 0xB1);
+                return _mm512_fmaddsub_ps(x, wr, _mm512_mul_ps(xs, wi));
+            }
+        };
+
+        template <std::floating_point T>
+        struct rvec;
+
+        template <>
+        struct rvec<double>
+        {
+            using reg = __m512d;
+            static constexpr size_t lanes = 8;
+
+            static reg load(const double* p) { return _mm512_loadu_pd(p); }
+            static void store(double* p, reg a) { _mm512_storeu_pd(p, a); }
+            static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+            static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_pd(a, b, c); }
+        };
+
+        template <>
+        struct rvec<float>
+        {
+            using reg = __m512;
+            static constexpr size_t lanes = 16;
+
+            static reg load(const float* p) { return _mm512_loadu_ps(p); }
+            static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+            static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+            static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_ps(a, b, c); }
+        };
+
+        #include "fft_butterflies.hpp"
+    }
+    #pragma GCC pop_options
+#endif
+
+    /**
+     * @brief All the butterfly stages of the radix-2 DIT FFT over a contiguous bit-reversed sequence,
+     * vectorized with the given instruction set. The stages whose blocks are narrower than a register run scalar.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param x The sequence, a power of 2 complex numbers in the bit-reversed order.
+     * @param size The number of complex numbers.
+     * @param twiddles Stage-wise twiddle tables: the stage of N = 2h points starts at twiddles[h - 1].
+     * @param inverse true for IFFT, false for FFT.
+     */
+    template <std::floating_point T>
+    void butterflies(simd::isa set, std::complex<T>* x, size_t size, const std::complex<T>* twiddles, bool inverse)
+    {
+        T*       data = reinterpret_cast<T*>(x);
+        const T* tw   = reinterpret_cast<const T*>(twiddles);
+
+        if (size < 4)
+        {
+            if (size == 2)
+                scalar::radix2_stage<scalar::vec<T>>(data, size, 1, tw);
+            return;
+        }
+        scalar::radix4_first_stage(data, size, inverse);
+
+        size_t h = 4;
+        switch (set)
+        {
+#if SDR_SIMD_X86
+        case simd::isa::avx512:
+            for (; h < avx512::vec<T>::lanes && 2 * h <= size; h *= 2)
+                scalar::radix2_stage<scalar::vec<T>>(data, size, h, tw + 2 * (h - 1));
+            avx512::stages<avx512::vec<T>>(data, size, h, tw);
+            break;
+        case simd::isa::avx2:
+            avx2::stages<avx2::vec<T>>(data, size, h, tw);
+            break;
+#endif
+        default:
+            scalar::stages<scalar::vec<T>>(data, size, h, tw);
+            break;
+        }
+    }
+
+    /**
+     * @brief The out-of-place Stockham autosort FFT: src is transformed into dst in the natural order,
+     * ping-ponging between dst and scratch so that the last stage lands in dst. src is left intact.
+     * Runs radix-4 passes while possible. The passes with fewer sub-transforms than a register holds run scalar.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param src The sequence, a power of 2 complex numbers.
+     * @param dst The transform, must not overlap src or scratch.
+     * @param scratch The work area of size complex numbers.
+     * @param size The number of complex numbers.
+     * @param twiddles Stage-wise twiddle tables: the roots of n points start at twiddles[n / 2 - 1].
+     * @param inverse true for IFFT, false for FFT.
+     */
+    template <std::floating_point T>
+    void stockham(simd::isa set, const std::complex<T>* src, std::complex<T>* dst, std::complex<T>* scratch, size_t size,
+                  const std::complex<T>* twiddles, bool inverse)
+    {
+        size_t passes = 0; // Radix-4 while possible, then radix-2
+        for (size_t n = size; n > 1; n >>= (n >= 4 ? 2 : 1))
+            ++passes;
+        if (passes == 0)
+        {
+            std::copy(src, src + size, dst);
+            return;
+        }
+
+        const T  rot[2] = { 0, inverse ? T{1} : T{-1} };
+        const T* tw = reinterpret_cast<const T*>(twiddles);
+        const T* x  = reinterpret_cast<const T*>(src);
+        T*       y  = reinterpret_cast<T*>(passes % 2 ? dst : scratch);
+        T*       z  = reinterpret_cast<T*>(passes % 2 ? scratch : dst);
+        for (size_t s = 1; s < size; )
+        {
+            const size_t radix = size / s >= 4 ? 4 : 2;
+            const T*     w     = tw + 2 * (size / s / 2 - 1);
+            const auto   stage = [&](auto radix4_stage, auto radix2_stage)
+            {
+                if (radix == 4)
+                    radix4_stage(x, y, size, s, w, rot);
+                else
+                    radix2_stage(x, y, size, s, w);
+            };
+
+            switch (set)
+            {
+#if SDR_SIMD_X86
+            case simd::isa::avx512:
+                if (s >= avx512::vec<T>::lanes)
+                {
+                    stage(avx512::stockham_radix4_stage<avx512::vec<T>, T>, avx512::stockham_stage<avx512::vec<T>, T>);
+                    break;
+                }
+                [[fallthrough]];
+            case simd::isa::avx2:
+                if (s >= avx2::vec<T>::lanes)
+                {
+                    stage(avx2::stockham_radix4_stage<avx2::vec<T>, T>, avx2::stockham_stage<avx2::vec<T>, T>);
+                    break;
+                }
+                [[fallthrough]];
+#endif
+            default:
+                stage(scalar::stockham_radix4_stage<scalar::vec<T>, T>, scalar::stockham_stage<scalar::vec<T>, T>);
+                break;
+            }
+            x = y;
+            std::swap(y, z);
+            s *= radix;
+        }
+    }
+
+    /**
+     * @brief All the butterfly stages of a batch of transforms in the interleaved layout (the point n of
+     * the transform k is at n * stride + k), vectorized across the transforms with the given instruction set.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param x The first transform of the batch to process, the rows in the bit-reversed order.
+     * @param size The transform size, a power of 2.
+     * @param stride The distance between the rows, i.e. the number of the transforms in the whole batch.
+     * @param cols The number of the transforms to process.
+     * @param twiddles Stage-wise twiddle tables: the stage of N = 2h points starts at twiddles[h - 1].
+     */
+    template <std::floating_point T>
+    void butterflies_interleaved(simd::isa set, std::complex<T>* x, size_t size, size_t stride, size_t cols, const std::complex<T>* twiddles)
+    {
+        T*       data = reinterpret_cast<T*>(x);
+        const T* tw   = reinterpret_cast<const T*>(twiddles);
+
+        switch (set)
+        {
+#if SDR_SIMD_X86
+        case simd::isa::avx512:
+            avx512::rows_stages<avx512::vec<T>>(data, size, stride, cols, tw);
+            break;
+        case simd::isa::avx2:
+            avx2::rows_stages<avx2::vec<T>>(data, size, stride, cols, tw);
+            break;
+#endif
+        default:
+            scalar::rows_stages<scalar::vec<T>>(data, size, stride, cols, tw);
+            break;
+        }
+    }
+
+    /**
+     * @brief Pointwise complex multiplication x[i] *= y[i] vectorized with the given instruction set.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param x The multiplied sequence, n complex numbers.
+     * @param y The multiplier sequence, n complex numbers.
+     * @param n The number of complex numbers.
+     */
+    template <std::floating_point T>
+    void multiply(simd::isa set, std::complex<T>* x, const std::complex<T>* y, size_t n)
+    {
+        T*       a = reinterpret_cast<T*>(x);
+        const T* b = reinterpret_cast<const T*>(y);
+
+        switch (set)
+        {
+#if SDR_SIMD_X86
+        case simd::isa::avx512:
+            avx512::multiply<avx512::vec<T>>(a, b, n);
+            break;
+        case simd::isa::avx2:
+            avx2::multiply<avx2::vec<T>>(a, b, n);
+            break;
+#endif
+        default:
+            scalar::multiply<scalar::vec<T>>(a, b, n);
+            break;
+        }
+    }
+
+    /**
+     * @brief All the butterfly stages of the radix-2 DIT FFT over a bit-reversed sequence in the split layout,
+     * vectorized with the given instruction set. The stages whose blocks are narrower than a register run scalar.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param re The real parts, a power of 2 values in the bit-reversed order.
+     * @param im The imaginary parts in the bit-reversed order.
+     * @param size The number of complex numbers.
+     * @param twiddles_re The real parts of the stage-wise twiddle tables: the stage of N = 2h points starts at [h - 1].
+     * @param twiddles_im The imaginary parts, laid out the same way.
+     */
+    template <std::floating_point T>
+    void butterflies_split(simd::isa set, T* re, T* im, size_t size, const T* twiddles_re, const T* twiddles_im)
+    {
+        const auto narrow = [&](size_t lanes)
+        {
+            size_t h = 1;
+            for (; h < lanes && 2 * h <= size; h *= 2)
+                scalar::split_radix2_stage<scalar::rvec<T>>(re, im, size, h, twiddles_re + h - 1, twiddles_im + h - 1);
+            return h;
+        };
+
+        switch (set)
+        {
+#if SDR_SIMD_X86
+        case simd::isa::avx512:
+            avx512::split_stages<avx512::rvec<T>>(re, im, size, narrow(avx512::rvec<T>::lanes), twiddles_re, twiddles_im);
+            break;
+        case simd::isa::avx2:
+            avx2::split_stages<avx2::rvec<T>>(re, im, size, narrow(avx2::rvec<T>::lanes), twiddles_re, twiddles_im);
+            break;
+#endif
+        default:
+            scalar::split_stages<scalar::rvec<T>>(re, im, size, 1, twiddles_re, twiddles_im);
+            break;
+        }
+    }
+}
\ No newline at end of file
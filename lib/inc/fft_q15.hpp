@@ -0,0 +1,338 @@
+#pragma once
+
+#include "fft.hpp"
+#include "fixed_point.hpp"
+#include "simd.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if SDR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace fft::detail::q15
+{
+    inline uint32_t magnitude(int32_t v) noexcept
+    {
+        return static_cast<uint32_t>(v < 0 ? -v : v);
+    }
+
+    /**
+     * @brief A radix-2 DIT stage of the block-floating-point FFT, combining the blocks of h points.
+     * The inputs are scaled up by 2^up first and the outputs down by 2^down with rounding.
+     * The twiddles are Q15 pairs, wa[2j..] = (wr, -wi) and wb[2j..] = (wi, wr), so that the products are
+     * the dot products of the sample with them, as computed by the vector multiply-add of int16 pairs.
+     *
+     * @return The OR of the output magnitudes, of the bit width of the largest one.
+     */
+    inline uint32_t stage(fixed::iq16* x, size_t size, size_t h, const int16_t* wa, const int16_t* wb, int up, int down)
+    {
+        const int32_t round = (int32_t{1} << down) >> 1;
+        uint32_t peak = 0;
+        for (size_t i = 0; i < size; i += 2 * h)
+        {
+            fixed::iq16* a = x + i;
+            fixed::iq16* b = x + i + h;
+            for (size_t j = 0; j < h; ++j)
+            {
+                const int32_t xr = int32_t{a[j].re} << up;
+                const int32_t xi = int32_t{a[j].im} << up;
+                const int32_t yr = int32_t{b[j].re} << up;
+                const int32_t yi = int32_t{b[j].im} << up;
+                const int32_t tr = (yr * wa[2 * j] + yi * wa[2 * j + 1] + (1 << (fixed::q15_bits - 1))) >> fixed::q15_bits;
+                const int32_t ti = (yr * wb[2 * j] + yi * wb[2 * j + 1] + (1 << (fixed::q15_bits - 1))) >> fixed::q15_bits;
+
+                // Within int16 by the choice of the shift
+                const int32_t ar = (xr + tr + round) >> down;
+                const int32_t ai = (xi + ti + round) >> down;
+                const int32_t br = (xr - tr + round) >> down;
+                const int32_t bi = (xi - ti + round) >> down;
+                a[j] = { static_cast<int16_t>(ar), static_cast<int16_t>(ai) };
+                b[j] = { static_cast<int16_t>(br), static_cast<int16_t>(bi) };
+                peak |= magnitude(ar) | magnitude(ai) | magnitude(br) | magnitude(bi);
+            }
+        }
+        return peak;
+    }
+
+#if SDR_SIMD_X86
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+    /**
+     * @brief The stage of stage() on AVX2, bit-exact with it: 8 samples a register, 16 a step.
+     * The blocks of fewer than 8 points are regrouped in registers so that one holds the first halves
+     * of the blocks and the other one the second halves. Sequences of at least 16 points.
+     */
+    inline uint32_t stage_avx2(fixed::iq16* x, size_t size, size_t h, const int16_t* wa, const int16_t* wb, int up, int down)
+    {
+        const __m128i scale_up   = _mm_cvtsi32_si128(up);
+        const __m128i scale_down = _mm_cvtsi32_si128(down);
+        const __m256i round = _mm256_set1_epi32((int32_t{1} << down) >> 1);
+        const __m256i half  = _mm256_set1_epi32(1 << (fixed::q15_bits - 1));
+        __m256i peak = _mm256_setzero_si256();
+
+        const auto butterfly = [&](__m256i& a, __m256i& b, __m256i wra, __m256i wrb)
+        {
+            const __m256i va = _mm256_sll_epi16(a, scale_up);
+            const __m256i vb = _mm256_sll_epi16(b, scale_up);
+            const __m256i tr = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(vb, wra), half), fixed::q15_bits);
+            const __m256i ti = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(vb, wrb), half), fixed::q15_bits);
+            const __m256i xr = _mm256_srai_epi32(_mm256_slli_epi32(va, 16), 16);
+            const __m256i xi = _mm256_srai_epi32(va, 16);
+
+            const __m256i ar = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(xr, tr), round), scale_down);
+            const __m256i ai = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(xi, ti), round), scale_down);
+            const __m256i br = _mm256_sra_epi32(_mm256_add_epi32(_mm256_sub_epi32(xr, tr), round), scale_down);
+            const __m256i bi = _mm256_sra_epi32(_mm256_add_epi32(_mm256_sub_epi32(xi, ti), round), scale_down);
+            a = _mm256_blend_epi16(ar, _mm256_slli_epi32(ai, 16), 0xAA);
+            b = _mm256_blend_epi16(br, _mm256_slli_epi32(bi, 16), 0xAA);
+
+            peak = _mm256_or_si256(peak, _mm256_or_si256(_mm256_or_si256(_mm256_abs_epi32(ar), _mm256_abs_epi32(ai)),
+                                                         _mm256_or_si256(_mm256_abs_epi32(br), _mm256_abs_epi32(bi))));
+        };
+
+        auto* p = reinterpret_cast<__m256i*>(x);
+        const size_t steps = size / 16;
+        if (h >= 8)
+        {
+            for (size_t i = 0; i < size; i += 2 * h)
+            {
+                auto* a = reinterpret_cast<__m256i*>(x + i);
+                auto* b = reinterpret_cast<__m256i*>(x + i + h);
+                for (size_t j = 0; j < h; j += 8, ++a, ++b)
+                {
+                    __m256i va = _mm256_loadu_si256(a);
+                    __m256i vb = _mm256_loadu_si256(b);
+                    butterfly(va, vb, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wa + 2 * j)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + 2 * j)));
+                    _mm256_storeu_si256(a, va);
+                    _mm256_storeu_si256(b, vb);
+                }
+            }
+        }
+        else if (h == 4) // A block per 128-bit lane: the halves of the lanes are swapped across the registers
+        {
+            const __m256i wra = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(wa)));
+            const __m256i wrb = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(wb)));
+            for (size_t k = 0; k < steps; ++k, p += 2)
+            {
+                const __m256i r0 = _mm256_loadu_si256(p);
+                const __m256i r1 = _mm256_loadu_si256(p + 1);
+                __m256i a = _mm256_permute2x128_si256(r0, r1, 0x20);
+                __m256i b = _mm256_permute2x128_si256(r0, r1, 0x31);
+                butterfly(a, b, wra, wrb);
+                _mm256_storeu_si256(p, _mm256_permute2x128_si256(a, b, 0x20));
+                _mm256_storeu_si256(p + 1, _mm256_permute2x128_si256(a, b, 0x31));
+            }
+        }
+        else if (h == 2) // Two blocks per 128-bit lane, the halves of the blocks are 64 bits
+        {
+            int64_t wa2, wb2;
+            std::memcpy(&wa2, wa, sizeof(wa2));
+            std::memcpy(&wb2, wb, sizeof(wb2));
+            const __m256i wra = _mm256_set1_epi64x(wa2);
+            const __m256i wrb = _mm256_set1_epi64x(wb2);
+            for (size_t k = 0; k < steps; ++k, p += 2)
+            {
+                const __m256i r0 = _mm256_loadu_si256(p);
+                const __m256i r1 = _mm256_loadu_si256(p + 1);
+                __m256i a = _mm256_unpacklo_epi64(r0, r1);
+                __m256i b = _mm256_unpackhi_epi64(r0, r1);
+                butterfly(a, b, wra, wrb);
+                _mm256_storeu_si256(p, _mm256_unpacklo_epi64(a, b));
+                _mm256_storeu_si256(p + 1, _mm256_unpackhi_epi64(a, b));
+            }
+        }
+        else // h == 1: the halves of the blocks are the even and the odd samples
+        {
+            int32_t wa1, wb1;
+            std::memcpy(&wa1, wa, sizeof(wa1));
+            std::memcpy(&wb1, wb, sizeof(wb1));
+            const __m256i wra = _mm256_set1_epi32(wa1);
+            const __m256i wrb = _mm256_set1_epi32(wb1);
+            for (size_t k = 0; k < steps; ++k, p += 2)
+            {
+                const __m256 r0 = _mm256_castsi256_ps(_mm256_loadu_si256(p));
+                const __m256 r1 = _mm256_castsi256_ps(_mm256_loadu_si256(p + 1));
+                __m256i a = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m256i b = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, _MM_SHUFFLE(3, 1, 3, 1)));
+                butterfly(a, b, wra, wrb);
+                _mm256_storeu_si256(p, _mm256_unpacklo_epi32(a, b));
+                _mm256_storeu_si256(p + 1, _mm256_unpackhi_epi32(a, b));
+            }
+        }
+
+        __m128i folded = _mm_or_si128(_mm256_castsi256_si128(peak), _mm256_extracti128_si256(peak, 1));
+        folded = _mm_or_si128(folded, _mm_shuffle_epi32(folded, 0x4E));
+        folded = _mm_or_si128(folded, _mm_shuffle_epi32(folded, 0xB1));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(folded));
+    }
+    #pragma GCC pop_options
+#endif
+}
+
+namespace fft
+{
+    /**
+     * @brief A precomputed block-floating-point FFT of the int16 IQ samples, i.e. of Q15 fractions.
+     * The samples stay 16-bit all the way, a quarter of the memory traffic of std::complex<double>
+     * and a half of std::complex<float>. Every butterfly can grow the magnitude by up to 1 + sqrt(2),
+     * so every stage is scaled by 2^-s, s in [-13, 2], chosen by the peak of its input: the headroom is kept
+     * and the weak signals are scaled up to the full precision rather than lost in the rounding. The shifts add up
+     * to the block exponent reported by execute, the only extra state the receiver needs to keep the dynamic range.
+     * The peak of a stage is tracked while the previous one stores, so the scaling costs no pass of its own.
+     * Sequences of at least 16 points run 8 samples a register on AVX2 and AVX-512 machines.
+     */
+    class q15_plan
+    {
+    public:
+        /**
+         * @brief Creates the plan.
+         *
+         * @param size Size of the sequences to transform, a power of 2.
+         * @param dir Direction of the transform; the inverse one is non-scaled.
+         * @param set Instruction set of the stages, the widest one supported by the CPU by default.
+         * @return std::expected<q15_plan, std::string>
+         * - The plan on success;
+         * - Error string on failure.
+         */
+        static std::expected<q15_plan, std::string> create(size_t size, direction dir = direction::forward, simd::isa set = simd::detect())
+        {
+            if (!simd::supported(set))
+                return std::unexpected(std::format("The instruction set {} is not supported by the CPU", simd::name(set)));
+            if (size == 0 || (size & (size - 1)) != 0)
+                return std::unexpected(std::format("The fixed-point FFT requires a power of 2 size, got {}", size));
+            if (size > std::numeric_limits<uint32_t>::max() / 4)
+                return std::unexpected("The sequence size exceeds the supported maximum");
+
+            q15_plan p;
+            p.size_ = size;
+            p.dir_ = dir;
+            p.isa_ = set;
+            std::vector<uint32_t> index;
+            detail::bit_reverse_table(size, index, p.swaps_);
+
+            const long double sign = dir == direction::inverse ? 1.0L : -1.0L;
+            p.twiddles_a_.reserve(2 * size);
+            p.twiddles_b_.reserve(2 * size);
+            for (size_t N = 2; N <= size; N <<= 1)
+                for (size_t j = 0; j < N / 2; ++j)
+                {
+                    const long double theta = sign * 2.0L * std::numbers::pi_v<long double> * j / N;
+                    // +-1.0 saturate to +-(1 - 2^-15), so that the negated ones fit int16 too
+                    const int16_t wr = std::max<int16_t>(fixed::to_q15(static_cast<double>(std::cos(theta))), -INT16_MAX);
+                    const int16_t wi = std::max<int16_t>(fixed::to_q15(static_cast<double>(std::sin(theta))), -INT16_MAX);
+                    p.twiddles_a_.insert(p.twiddles_a_.end(), { wr, static_cast<int16_t>(-wi) });
+                    p.twiddles_b_.insert(p.twiddles_b_.end(), { wi, wr });
+                }
+            return p;
+        }
+
+        /**
+         * @brief Transforms the sequence in place.
+         *
+         * @param x The samples of the block exponent `exponent`, i.e. standing for x[n] / 2^15 * 2^exponent.
+         * @param exponent The block exponent of the input.
+         * @return std::expected<int, std::string>
+         * - The block exponent of the transform on success: the non-scaled transform is x[k] / 2^15 * 2^exponent;
+         * - Error string on failure.
+         */
+        std::expected<int, std::string> execute(std::span<fixed::iq16> x, int exponent = 0) const
+        {
+            if (x.size() != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+
+            detail::bit_reverse_permute(x.begin(), swaps_);
+
+            // The OR of the magnitudes has the bit width of the largest one, all the thresholds are powers of 2
+            uint32_t peak = 0;
+            for (const auto& v: x)
+                peak |= detail::q15::magnitude(v.re) | detail::q15::magnitude(v.im);
+
+            for (size_t h = 1; h < size_; h <<= 1)
+            {
+                // (1 + sqrt(2)) * peak / 2^shift stays below 2^15, while a weak block is scaled up to the same range
+                const int shift = peak >= (1u << 14) ? 2 : peak >= (1u << 13) ? 1 : peak > 0 ? std::bit_width(peak) - 13 : 0;
+                const int16_t* wa = twiddles_a_.data() + 2 * (h - 1);
+                const int16_t* wb = twiddles_b_.data() + 2 * (h - 1);
+                exponent += shift;
+#if SDR_SIMD_X86
+                if (isa_ != simd::isa::scalar && size_ >= 16)
+                {
+                    peak = detail::q15::stage_avx2(x.data(), size_, h, wa, wb, std::max(0, -shift), std::max(0, shift));
+                    continue;
+                }
+#endif
+                peak = detail::q15::stage(x.data(), size_, h, wa, wb, std::max(0, -shift), std::max(0, shift));
+            }
+            return exponent;
+        }
+
+        size_t size() const noexcept { return size_; }
+        direction dir() const noexcept { return dir_; }
+        simd::isa isa() const noexcept { return isa_; }
+
+    private:
+        q15_plan() = default;
+
+        size_t                                      size_ = 0;
+        direction                                   dir_ = direction::forward;
+        simd::isa                                   isa_ = simd::isa::scalar;
+        std::vector<int16_t>                        twiddles_a_; // (wr, -wi) pairs, the stage of 2h points occupies [2(h - 1), 2(2h - 1))
+        std::vector<int16_t>                        twiddles_b_; // (wi, wr) pairs
+        std::vector<std::pair<uint32_t, uint32_t>>  swaps_;
+    };
+
+    /**
+     * @brief Performs the block-floating-point FFT of the int16 IQ samples in place.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     *
+     * @param x The samples, a power of 2 of them.
+     * @param exponent The block exponent of the input.
+     * @return std::expected<int, std::string>
+     * - The block exponent of the spectrum on success;
+     * - Error string on failure.
+     */
+    inline std::expected<int, std::string> fft2(std::span<fixed::iq16> x, int exponent = 0)
+    {
+        return detail::cached<q15_plan>(x.size(), direction::forward)
+            .and_then([x, exponent](const q15_plan* p)
+            {
+                return p->execute(x, exponent);
+            });
+    }
+
+    /**
+     * @brief Performs the block-floating-point IFFT of the int16 IQ samples in place.
+     * The 1/N scaling costs nothing, it only lowers the block exponent by log2(N).
+     *
+     * @param x The spectrum, a power of 2 of the bins.
+     * @param exponent The block exponent of the spectrum.
+     * @return std::expected<int, std::string>
+     * - The block exponent of the sequence on success;
+     * - Error string on failure.
+     */
+    inline std::expected<int, std::string> ifft2(std::span<fixed::iq16> x, int exponent = 0)
+    {
+        return detail::cached<q15_plan>(x.size(), direction::inverse)
+            .and_then([x, exponent](const q15_plan* p)
+            {
+                return p->execute(x, exponent);
+            })
+            .transform([size = x.size()](int e)
+            {
+                return e - std::countr_zero(size);
+            });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "fft.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <concepts>
+#include <expected>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filter
+{
+    /**
+     * The streaming FIR filter of the uniformly partitioned overlap-save convolution. The taps are cut into P partitions
+     * of B taps, and the spectra of the partitions zero padded to 2B are computed once. Every B input samples make
+     * a block: the FFT of the 2B latest samples enters a frequency-domain delay line of the last P block spectra,
+     * the output spectrum is the sum of their products with the partition spectra, and its IFFT yields B output
+     * samples, the first half being the wrapped-around part thrown away. A sample thus costs O(log B + P) however long
+     * the filter, instead of O(taps) of the direct form. The samples are fed in the chunks of any size; the state
+     * carried between the calls delays the output by the block of B samples.
+     */
+    template <std::floating_point T>
+    class fir
+    {
+    public:
+        /**
+         * @brief Creates the filter.
+         *
+         * @param taps The impulse response.
+         * @param block The partition size B, the latency; 0 picks a power of 2 near the number of the taps, at most 1024.
+         * @param set Instruction set of the FFT, the widest one supported by the CPU by default.
+         * @return std::expected<fir, std::string>
+         * - The filter on success;
+         * - Error string on failure.
+         */
+        static std::expected<fir, std::string> create(std::span<const std::complex<T>> taps, size_t block = 0, simd::isa set = simd::detect())
+        {
+            if (taps.empty())
+                return std::unexpected("The filter has no taps");
+            const size_t B = block ? block : std::bit_ceil(std::clamp<size_t>(taps.size(), 16, 1024));
+
+            auto forward = fft::plan<T>::create(2 * B, fft::direction::forward, set);
+            auto inverse = fft::plan<T>::create(2 * B, fft::direction::inverse, set);
+            if (!forward)
+                return std::unexpected(forward.error());
+            if (!inverse)
+                return std::unexpected(inverse.error());
+
+            fir f(std::move(*forward), std::move(*inverse), taps.size(), B);
+            const size_t P = (taps.size() + B - 1) / B;
+            f.partitions_.assign(P * 2 * B, std::complex<T>{});
+            f.spectra_.assign(P * 2 * B, std::complex<T>{});
+            const T scale = T{1} / static_cast<T>(2 * B); // the IFFT scaling folded into the partitions
+            for (size_t p = 0; p < P; ++p)
+            {
+                const auto partition = std::span(f.partitions_).subspan(p * 2 * B, 2 * B);
+                for (size_t t = p * B; t < std::min(taps.size(), (p + 1) * B); ++t)
+                    partition[t - p * B] = taps[t] * scale;
+                if (auto r = f.forward_.execute(partition.begin(), partition.end()); !r)
+                    return std::unexpected(r.error());
+            }
+            return f;
+        }
+
+        /**
+         * @brief Filters the next chunk of the stream.
+         *
+         * @param in The input samples, any number of them.
+         * @param out The output samples, as many, the filtered stream delayed by latency() samples.
+         */
+        std::expected<void, std::string> process(std::span<const std::complex<T>> in, std::span<std::complex<T>> out)
+        {
+            if (in.size() != out.size())
+                return std::unexpected(std::format("The output size={} differs from the input size={}", out.size(), in.size()));
+
+            const size_t B = block_;
+            for (size_t i = 0; i < in.size();)
+            {
+                const size_t n = std::min(in.size() - i, B - fill_);
+                std::copy_n(in.begin() + i, n, window_.begin() + B + fill_);    // the new half of the window
+                std::copy_n(output_.begin() + fill_, n, out.begin() + i);      // the output of the previous block
+                fill_ += n;
+                i += n;
+                if (fill_ == B)
+                {
+                    if (auto r = convolve(); !r)
+                        return r;
+                    fill_ = 0;
+                }
+            }
+            return {};
+        }
+
+        // Forgets the stream, as if fed with the silence
+        void reset()
+        {
+            std::fill(window_.begin(), window_.end(), std::complex<T>{});
+            std::fill(output_.begin(), output_.end(), std::complex<T>{});
+            std::fill(spectra_.begin(), spectra_.end(), std::complex<T>{});
+            fill_ = 0;
+            slot_ = 0;
+        }
+
+        size_t size() const noexcept { return taps_; }
+        size_t block_size() const noexcept { return block_; }
+        size_t latency() const noexcept { return block_; }
+
+    private:
+        fir(fft::plan<T>&& forward, fft::plan<T>&& inverse, size_t taps, size_t block)
+            : forward_(std::move(forward))
+            , inverse_(std::move(inverse))
+            , taps_(taps)
+            , block_(block)
+            , window_(2 * block)
+            , output_(block)
+            , sum_(2 * block) {}
+
+        // The block of the B samples in the new half of the window
+        std::expected<void, std::string> convolve()
+        {
+            const size_t B = block_, L = 2 * B;
+            const size_t P = spectra_.size() / L;
+            auto* X = spectra_.data() + slot_ * L;
+            if (auto r = forward_.execute(window_.begin(), window_.end(), X); !r)
+                return r;
+
+            // The sum of the products of the delay line, the newest spectrum with the first partition
+            std::fill(sum_.begin(), sum_.end(), std::complex<T>{});
+            T* y = reinterpret_cast<T*>(sum_.data());
+            for (size_t p = 0; p < P; ++p)
+            {
+                const T* x = reinterpret_cast<const T*>(spectra_.data() + (slot_ + P - p) % P * L);
+                const T* h = reinterpret_cast<const T*>(partitions_.data() + p * L);
+                for (size_t k = 0; k < 2 * L; k += 2)
+                {
+                    y[k]     += x[k] * h[k] - x[k + 1] * h[k + 1];
+                    y[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+                }
+            }
+            if (auto r = inverse_.execute(sum_.begin(), sum_.end()); !r)
+                return r;
+
+            std::copy(sum_.begin() + B, sum_.end(), output_.begin());      // the linear part of the circular convolution
+            std::copy(window_.begin() + B, window_.end(), window_.begin()); // the new half becomes the old one
+            slot_ = (slot_ + 1) % P;
+            return {};
+        }
+
+        fft::plan<T>                    forward_;
+        fft::plan<T>                    inverse_;
+        size_t                          taps_;
+        size_t                          block_;
+        std::vector<std::complex<T>>    partitions_;    // the spectra of the partitions, 2B each
+        std::vector<std::complex<T>>    spectra_;       // the delay line of the spectra of the input blocks, a ring of P
+        std::vector<std::complex<T>>    window_;        // the 2B latest input samples, the new half being filled
+        std::vector<std::complex<T>>    output_;        // the output of the last block
+        std::vector<std::complex<T>>    sum_;
+        size_t                          fill_ = 0;      // the samples of the new half so far
+        size_t                          slot_ = 0;      // the slot of the newest spectrum
+    };
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <concepts>
+#include <limits>
+
+namespace fixed
+{
+    /**
+     * An interleaved int16 IQ sample as delivered by the front ends: Q15 fractions, i.e. the value is re / 2^15.
+     * With a block exponent e shared by a whole block of samples the value becomes re / 2^15 * 2^e.
+     */
+    struct iq16
+    {
+        int16_t re = 0;
+        int16_t im = 0;
+
+        bool operator==(const iq16&) const = default;
+    };
+
+    inline constexpr int q15_bits = 15;
+    inline constexpr int32_t q15_one = int32_t{1} << q15_bits;
+
+    /**
+     * @brief Rounds and saturates to int16.
+     */
+    constexpr int16_t saturate(int64_t v) noexcept
+    {
+        return static_cast<int16_t>(std::clamp<int64_t>(v, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max()));
+    }
+
+    /**
+     * @brief Converts the fraction in [-1, 1) to Q15, saturating out of range values.
+     */
+    template <std::floating_point T>
+    int16_t to_q15(T v) noexcept
+    {
+        return saturate(std::llround(v * q15_one));
+    }
+
+    /**
+     * @brief Converts the sample of the block exponent to the complex number it stands for.
+     */
+    template <std::floating_point T>
+    std::complex<T> to_complex(iq16 v, int exponent = 0) noexcept
+    {
+        const T scale = std::ldexp(T{1}, exponent - q15_bits);
+        return { v.re * scale, v.im * scale };
+    }
+
+    /**
+     * @brief Converts the complex number in [-1, 1) to a Q15 sample, saturating out of range values.
+     */
+    template <std::floating_point T>
+    iq16 to_iq16(std::complex<T> v) noexcept
+    {
+        return { to_q15(v.real()), to_q15(v.imag()) };
+    }
+}
\ No newline at end of file
@@ -1,113 +1,468 @@
 #pragma once
 
+#include "bit_stream.hpp"
+#include "fixed_point.hpp"
+#include "modulation_kernels.hpp"
+#include "simd.hpp"
+#include "split_buffer.hpp"
 #include <concepts>
+#include <expected>
+#include <format>
+#include <iterator>
+#include <span>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <complex>
 #include <stdint.h>
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <cmath>
 
 namespace modulation
 {
-    struct eBPSK{};    // 1bit/symbol
-    struct eQPSK{};    // 2bits/symbol
-    struct e16QAM
+    namespace detail
     {
-        static constexpr size_t                             bits_per_symbol = 4;
-        // Normalization factor for averaging symbol power to 1
+        // The binary-reflected Gray code: the codes of the adjacent values differ by a single bit
+        constexpr uint32_t gray(uint32_t v) noexcept
+        {
+            return v ^ (v >> 1);
+        }
+
+        constexpr uint32_t gray_inverse(uint32_t g) noexcept
+        {
+            for (uint32_t shift = 1; shift < 32; shift <<= 1)
+                g ^= g >> shift;
+            return g;
+        }
+    }
+
+    /**
+     * A square Gray-coded QAM of 2^Bits points: Bits/2 bits per axis, the most significant half on the real one.
+     * The levels of an axis are -(L-1), ..., -1, +1, ..., L-1 for L = 2^(Bits/2), and the adjacent levels differ
+     * by a single bit. Thus, if noise falsely shifts the symbol closer to a neighbour, this flips just one bit.
+     * Viterbi decoding is very efficient in recovering one error bit, hence the Bit Error Rate (BER) is better.
+     * E.g. 16-QAM: 0000 is -3-3j, 0001 is -3-1j, 0011 is -3+1j, 0010 is -3+3j, 0110 is -1+3j and so on.
+     */
+    template <size_t Bits>
+    struct square_qam
+    {
+        static_assert(Bits % 2 == 0 && Bits >= 2 && Bits <= 16, "A square QAM carries an even number of bits per symbol");
+
+        static constexpr size_t                             bits_per_symbol = Bits;
+        static constexpr size_t                             axis_bits = Bits / 2;
+        static constexpr size_t                             levels = size_t{1} << axis_bits; // per axis
+
+        // Normalization factor for averaging symbol power to 1: the mean power of the square QAM is 2(M - 1)/3
         template <typename T>
-        static constexpr T                                  norm = T{1} / std::sqrt(T{10});
+        static constexpr T                                  norm = T{1} / std::sqrt(T{2} * (levels * levels - 1) / 3);
         // Norm inverse, precomputed
         template <typename T>
-        static constexpr T                                  inorm = std::sqrt(T{10});
-        
-        // Unnormalized Gray-coded 16-QAM where the adjacent symbols' binary indexes differ just by a single bit.
-        // Thus, if noise falsely shifts the symbol closer to a neighbour, this flips just one bit.
-        // Viterbi decoding is very efficient in recovering one error bit, hence the Bit Error Rate (BER) is better.
+        static constexpr T                                  inorm = std::sqrt(T{2} * (levels * levels - 1) / 3);
+        // The level index of the normalized coordinate v is (v + levels * norm) * inorm / 2, rounded down and clamped
+        template <typename T>
+        static constexpr detail::thresholds<T>              bounds = { levels * norm<T>, inorm<T> / 2, static_cast<T>(levels - 1) };
+
+        // The unnormalized level of the Gray code of an axis
+        static constexpr int level(uint32_t code) noexcept
+        {
+            return 2 * static_cast<int>(detail::gray_inverse(code)) - static_cast<int>(levels - 1);
+        }
+
+        template <typename T>
+        static constexpr std::array<std::complex<T>, size_t{1} << Bits> make_table()
+        {
+            std::array<std::complex<T>, size_t{1} << Bits> t{};
+            for (uint32_t s = 0; s < t.size(); ++s)
+                t[s] = { static_cast<T>(level(s >> axis_bits)), static_cast<T>(level(s & (levels - 1))) };
+            return t;
+        }
+
+        // Unnormalized points, indexed by the symbol bits
         template <typename T>
-        static constexpr std::array<std::complex<T>, 16> table =
-        {
-            /* 0000 */ -3-3j,
-            /* 0001 */ -3-1j,
-            /* 0010 */ -3+3j,
-            /* 0011 */ -3+1j,
-            /* 0100 */ -1-3j,
-            /* 0101 */ -1-1j,
-            /* 0110 */ -1+3j,
-            /* 0111 */ -1+1j,
-            /* 1000 */ +3-3j,
-            /* 1001 */ +3-1j,
-            /* 1010 */ +3+3j,
-            /* 1011 */ +3+1j,
-            /* 1100 */ +1-3j,
-            /* 1101 */ +1-1j,
-            /* 1110 */ +1+3j,
-            /* 1111 */ +1+1j
-        };
+        static constexpr std::array<std::complex<T>, size_t{1} << Bits> table = make_table<T>();
 
+        /**
+         * @brief The Gray code of the level nearest to the normalized coordinate: rounding to the level grid
+         * and clamping to the outermost levels, the same few operations for any order.
+         */
         template <typename T>
-        static uint8_t nearest(const std::complex<T>& pt) noexcept
+        static uint32_t slice(T v) noexcept
         {
-            uint8_t res = 0;
-            T       best = std::numeric_limits<T>::max();
-            auto    unp = pt * inorm<T>;
-            for (uint8_t i = 0; i != table<T>.size(); ++i)
+            return detail::gray(detail::level_index(v, bounds<T>));
+        }
+
+        /**
+         * @brief The hard decision: the symbol bits of the nearest point, in constant time.
+         */
+        template <typename T>
+        static uint32_t nearest(const std::complex<T>& pt) noexcept
+        {
+            return (slice(pt.real()) << axis_bits) | slice(pt.imag());
+        }
+    };
+
+    struct eBPSK // 1bit/symbol
+    {
+        static constexpr size_t                             bits_per_symbol = 1;
+        template <typename T>
+        static constexpr T                                  norm = T{1};
+        template <typename T>
+        static constexpr T                                  inorm = T{1};
+        template <typename T>
+        static constexpr std::array<std::complex<T>, 2>     table = { std::complex<T>{-1, 0}, std::complex<T>{+1, 0} };
+        // Unused, the decision is the sign
+        template <typename T>
+        static constexpr detail::thresholds<T>              bounds = { 0, 1, 1 };
+
+        template <typename T>
+        static uint32_t nearest(const std::complex<T>& pt) noexcept
+        {
+            return pt.real() >= 0;
+        }
+    };
+
+    struct eQPSK : square_qam<2> {};     // 2bits/symbol
+    struct e16QAM : square_qam<4> {};    // 4bits/symbol
+    struct e64QAM : square_qam<6> {};    // 6bits/symbol, LTE/Cable TV
+    struct e256QAM : square_qam<8> {};   // 8bits/symbol, 5G
+    struct e1024QAM : square_qam<10> {}; // 10bits/symbol, Wi-Fi 6
+
+    /**
+     * @brief A modulation: the table of the normalized-to-be points indexed by the symbol bits and the hard decision.
+     */
+    template <typename Mod>
+    concept constellation = requires(const std::complex<double>& pt)
+    {
+        { Mod::bits_per_symbol } -> std::convertible_to<size_t>;
+        { Mod::template norm<double> } -> std::convertible_to<double>;
+        { Mod::template table<double>[0] } -> std::convertible_to<std::complex<double>>;
+        { Mod::template nearest<double>(pt) } -> std::convertible_to<uint32_t>;
+    };
+
+    /**
+     * @brief The number of the symbols carrying the bytes, the last one padded with zero bits if needed.
+     */
+    template <constellation Mod>
+    constexpr size_t symbols(size_t bytes) noexcept
+    {
+        return (bytes * 8 + Mod::bits_per_symbol - 1) / Mod::bits_per_symbol;
+    }
+
+    namespace detail
+    {
+        /**
+         * @brief Calls fn(n, bits) for every symbol of the packed data, the most significant bits first.
+         */
+        template <size_t Bits, typename F>
+        void for_each_symbol(std::span<const uint8_t> in, F&& fn)
+        {
+            utils::bit_reader reader(in);
+            const size_t count = (in.size() * 8 + Bits - 1) / Bits;
+            for (size_t n = 0; n < count; ++n)
+                fn(n, reader.read(Bits));
+        }
+
+        // The orders of a whole number of symbols a byte, but BPSK, where eight points a byte outweigh the lookups
+        template <constellation Mod>
+        inline constexpr bool byte_mapped = Mod::bits_per_symbol >= 2 && 8 % Mod::bits_per_symbol == 0;
+
+        template <constellation Mod, typename T>
+        constexpr auto make_byte_table()
+        {
+            constexpr size_t bits = Mod::bits_per_symbol;
+            std::array<std::array<std::complex<T>, 8 / bits>, 256> t{};
+            for (size_t byte = 0; byte < t.size(); ++byte)
+                for (size_t k = 0; k < 8 / bits; ++k)
+                    t[byte][k] = Mod::template table<T>[(byte >> (8 - (k + 1) * bits)) & ((1u << bits) - 1)] * Mod::template norm<T>;
+            return t;
+        }
+
+        /**
+         * The normalized points of every byte value, e.g. 256 pairs for 16-QAM: the mapping is a copy a byte.
+         */
+        template <constellation Mod, typename T>
+            requires byte_mapped<Mod>
+        inline constexpr auto byte_table = make_byte_table<Mod, T>();
+
+        /**
+         * @brief Demaps the symbols into symbols * bits_per_symbol / 8 bytes. The square QAMs and BPSK in float and double
+         * take the vector kernels 8 or 16 symbols at a time, the remaining symbols and other constellations the nearest().
+         */
+        template <constellation Mod, typename T>
+        void demap(const std::complex<T>* in, size_t count, uint8_t* out, simd::isa set = simd::detect())
+        {
+            constexpr size_t bits = Mod::bits_per_symbol;
+            size_t head = 0;
+            if constexpr (std::floating_point<T> && requires { Mod::template bounds<T>; })
             {
-                T dx = unp.real() - table<T>[i].real();
-                T dy = unp.imag() - table<T>[i].imag();
-                T d2 = dx*dx + dy*dy;
-                if (d2 < best)
-                {
-                    best = d2;
-                    res = i;
-                }
+                head = count / 8 * 8;
+                hard_decisions<bits>(set, in, head, out, Mod::template bounds<T>);
             }
-            return res;
+            utils::bit_writer writer(out + head / 8 * bits);
+            for (size_t n = head; n < count; ++n)
+                writer.write(Mod::template nearest<T>(in[n]), bits);
+            writer.flush();
         }
-    };
+    }
 
-    struct e64QAM{};   // 6bits/symbol, LTE/Cable TV
-    struct e256QAM{};  // 8bits/symbol, 5G
-    struct e1024QAM{}; //
+    /**
+     * @brief Maps the packed data onto the constellation through the output iterator, allocating nothing.
+     * @return The number of the symbols written, symbols<Mod>(in.size()).
+     */
+    template <constellation Mod, typename T = double, std::output_iterator<std::complex<T>> Out>
+    size_t to_constl(std::span<const uint8_t> in, Out out, Mod m = {})
+    {
+        if constexpr (detail::byte_mapped<Mod>)
+        {
+            for (const uint8_t byte: in)
+                out = std::copy(detail::byte_table<Mod, T>[byte].begin(), detail::byte_table<Mod, T>[byte].end(), out);
+        }
+        else
+        {
+            detail::for_each_symbol<Mod::bits_per_symbol>(in, [&out](size_t, uint32_t bits)
+            {
+                *out++ = Mod::template table<T>[bits] * Mod::template norm<T>;
+            });
+        }
+        return symbols<Mod>(in.size());
+    }
+
+    /**
+     * @brief Maps the packed data onto the constellation into the caller's buffer, e.g. a reused frame buffer.
+     * @param out At least symbols<Mod>(in.size()) symbols.
+     * @return std::expected<size_t, std::string>
+     * - The number of the symbols written on success;
+     * - Error string if they do not fit.
+     */
+    template <constellation Mod, typename T>
+    std::expected<size_t, std::string> to_constl(std::span<const uint8_t> in, std::span<std::complex<T>> out, Mod m = {})
+    {
+        const size_t count = symbols<Mod>(in.size());
+        if (out.size() < count)
+            return std::unexpected(std::format("The output of size={} is short of the {} symbols", out.size(), count));
+        return to_constl<Mod, T>(in, out.begin());
+    }
 
     /**
-     * 
-     * @param in A sequence of 4-bit packed data
+     * @brief Maps the packed data onto the constellation.
+     * @param in The data, every symbol takes the next bits_per_symbol bits, the most significant ones first.
      */
-    template <typename Mod, typename T = double>
+    template <constellation Mod, typename T = double>
     std::vector<std::complex<T>> to_constl(const std::vector<uint8_t>& in, Mod m = {})
-        requires std::same_as<Mod, e16QAM> // Specialization/overload for 16-QAM
     {
-        std::vector<std::complex<T>> out;
-        out.reserve(in.size() * 2);
-    
-        for (uint8_t v: in)
+        std::vector<std::complex<T>> out(symbols<Mod>(in.size()));
+        to_constl<Mod, T>(in, out.begin());
+        return out;
+    }
+
+    template <constellation Mod, typename T = double>
+    std::vector<uint8_t> from_constl(const std::vector<std::complex<T>>& in, Mod m = {})
+    {
+        std::vector<uint8_t> out(in.size() * Mod::bits_per_symbol / 8);
+        detail::demap<Mod>(in.data(), in.size(), out.data());
+        return out;
+    }
+
+    /**
+     * @brief Demaps the symbols into the caller's buffer, e.g. a reused frame buffer; the padding bits are dropped.
+     * @param in The symbols, of std::complex<T>, double by default.
+     * @param out At least in.size() * bits_per_symbol / 8 bytes.
+     * @return std::expected<size_t, std::string>
+     * - The number of the bytes written on success;
+     * - Error string if they do not fit.
+     */
+    template <constellation Mod, typename T = double>
+    std::expected<size_t, std::string> from_constl(std::span<const std::complex<std::type_identity_t<T>>> in, std::span<uint8_t> out, Mod m = {})
+    {
+        const size_t count = in.size() * Mod::bits_per_symbol / 8;
+        if (out.size() < count)
+            return std::unexpected(std::format("The output of size={} is short of the {} bytes", out.size(), count));
+        detail::demap<Mod>(in.data(), in.size(), out.data());
+        return count;
+    }
+
+    /**
+     * @brief Demaps the symbols through the output iterator, allocating nothing: the vector decisions land in
+     * a small buffer on the stack a block at a time.
+     * @return The number of the bytes written, in.size() * bits_per_symbol / 8.
+     */
+    template <constellation Mod, typename T = double, std::output_iterator<uint8_t> Out>
+    size_t from_constl(std::span<const std::complex<std::type_identity_t<T>>> in, Out out, Mod m = {})
+    {
+        constexpr size_t block = 256; // symbols, a whole number of bytes
+        uint8_t bytes[block * Mod::bits_per_symbol / 8];
+        for (size_t n = 0; n < in.size(); n += block)
         {
-            uint8_t msb = (v >> 4) & 0xF;
-            uint8_t lsb = v & 0xF;
-        
-            out.push_back(Mod::template table<T>[msb] * Mod::template norm<T>);
-            out.push_back(Mod::template table<T>[lsb] * Mod::template norm<T>);
+            const auto part = in.subspan(n, std::min(block, in.size() - n));
+            const size_t count = part.size() * Mod::bits_per_symbol / 8;
+            detail::demap<Mod>(part.data(), part.size(), bytes);
+            out = std::copy(bytes, bytes + count, out);
         }
+        return in.size() * Mod::bits_per_symbol / 8;
+    }
+
+    namespace detail
+    {
+        /**
+         * @brief The soft decisions of the symbols into count * bits_per_symbol LLRs, see to_llr().
+         */
+        template <constellation Mod, typename O, std::floating_point T>
+        void llr(const std::complex<T>* in, size_t count, O* out, T noise_variance, T step, simd::isa set = simd::detect())
+        {
+            static_assert(requires { Mod::template bounds<T>; }, "The soft decisions are separable per axis for BPSK and the square QAMs only");
+            constexpr auto t = Mod::template bounds<T>;
+            // ln P(0) / P(1) = (d1^2 - d0^2) / N0: -4 re / N0 for BPSK, the level index units being 1 / scale apart otherwise
+            const T gain = Mod::bits_per_symbol == 1 ? -4 / noise_variance : 1 / (t.scale * t.scale * noise_variance);
+            soft_decisions<Mod::bits_per_symbol>(set, in, count, out, t, gain, step);
+        }
+    }
+
+    /**
+     * @brief The soft decisions for a decoder: the max-log log-likelihood ratios ln P(b = 0) / P(b = 1) of every bit,
+     * positive for a likely 0, in the order of the bits of to_constl(). Separable per I/Q axis, and linear in the axis
+     * value within the decision region of a level, so a bit is a table lookup and a multiply-add at any order:
+     * at most the cost of from_constl() for float, up to twice it for double, whose registers hold half the values.
+     *
+     * @param in The received symbols, of unit average power.
+     * @param noise_variance The variance E|n|^2 of the complex noise, positive.
+     * @param out bits_per_symbol LLRs per symbol, resized to fit.
+     * @return std::expected<void, std::string>
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <constellation Mod, std::floating_point T>
+    std::expected<void, std::string> to_llr(const std::vector<std::complex<T>>& in, T noise_variance, std::vector<T>& out, Mod m = {})
+    {
+        if (!(noise_variance > 0))
+            return std::unexpected(std::format("The noise variance={} is not positive", noise_variance));
+        out.resize(in.size() * Mod::bits_per_symbol);
+        detail::llr<Mod>(in.data(), in.size(), out.data(), noise_variance, T{1});
+        return {};
+    }
+
+    /**
+     * @brief The soft decisions quantized for a fixed-point decoder: the LLRs of to_llr() times step,
+     * rounded and saturated to [-127, 127].
+     *
+     * @param step The int8 steps per unit LLR, positive.
+     */
+    template <constellation Mod, std::floating_point T>
+    std::expected<void, std::string> to_llr(const std::vector<std::complex<T>>& in, T noise_variance, std::vector<int8_t>& out, T step, Mod m = {})
+    {
+        if (!(noise_variance > 0))
+            return std::unexpected(std::format("The noise variance={} is not positive", noise_variance));
+        if (!(step > 0))
+            return std::unexpected(std::format("The int8 step={} is not positive", step));
+        out.resize(in.size() * Mod::bits_per_symbol);
+        detail::llr<Mod>(in.data(), in.size(), out.data(), noise_variance, step);
+        return {};
+    }
+
+    /**
+     * @brief Maps onto the constellation in the split layout, ready for the split FFT path.
+     * @param in The packed data.
+     * @param out The symbols, resized to fit.
+     */
+    template <constellation Mod, std::floating_point T>
+    void to_constl(const std::vector<uint8_t>& in, utils::split_buffer<T>& out, Mod m = {})
+    {
+        out.resize(symbols<Mod>(in.size()));
+        auto re = out.real();
+        auto im = out.imag();
+        detail::for_each_symbol<Mod::bits_per_symbol>(in, [re, im](size_t n, uint32_t bits)
+        {
+            const auto pt = Mod::template table<T>[bits];
+            re[n] = pt.real() * Mod::template norm<T>;
+            im[n] = pt.imag() * Mod::template norm<T>;
+        });
+    }
+
+    template <constellation Mod, std::floating_point T>
+    std::vector<uint8_t> from_constl(const utils::split_buffer<T>& in, Mod m = {})
+    {
+        std::vector<uint8_t> out(in.size() * Mod::bits_per_symbol / 8);
+        utils::bit_writer writer(out.data());
+        for (size_t i = 0; i < in.size(); ++i)
+            writer.write(Mod::template nearest<T>(in[i]), Mod::bits_per_symbol);
+        writer.flush();
         return out;
     }
 
-    template <typename Mod, typename T = double>
-    std::vector<uint8_t> from_constl(const std::vector<std::complex<T>>& in, Mod m = {})
-        requires std::same_as<Mod, e16QAM> // Specialization/overload for 16-QAM
+    namespace detail
     {
-        std::vector<uint8_t> out;
-        out.reserve(in.size() / 2);
+        /**
+         * @brief The smallest block exponent fitting the outermost normalized level into Q15: the corners of 64-QAM and up
+         * reach beyond 1 once the average power is 1.
+         */
+        template <constellation Mod>
+        constexpr int q15_exponent() noexcept
+        {
+            double peak = 0;
+            for (const auto& pt: Mod::template table<double>)
+                peak = std::max({ peak, pt.real() < 0 ? -pt.real() : pt.real(), pt.imag() < 0 ? -pt.imag() : pt.imag() });
+            int exponent = 0;
+            for (peak *= Mod::template norm<double>; peak >= 1; peak /= 2)
+                ++exponent;
+            return exponent;
+        }
+
+        template <constellation Mod>
+        inline constexpr int q15_exponent_v = q15_exponent<Mod>();
+    }
+
+    /**
+     * @brief Maps onto the constellation in Q15, ready for the fixed-point FFT path.
+     * @param in The packed data.
+     * @param out The symbols, resized to fit.
+     * @return The block exponent of the symbols: they stand for out[n] / 2^15 * 2^exponent.
+     */
+    template <constellation Mod>
+    int to_constl(const std::vector<uint8_t>& in, std::vector<fixed::iq16>& out, Mod m = {})
+    {
+        constexpr int exponent = detail::q15_exponent_v<Mod>;
+        out.resize(symbols<Mod>(in.size()));
+        detail::for_each_symbol<Mod::bits_per_symbol>(in, [&out](size_t n, uint32_t bits)
+        {
+            out[n] = fixed::to_iq16(Mod::template table<double>[bits] * std::ldexp(Mod::template norm<double>, -exponent));
+        });
+        return exponent;
+    }
 
-        for (size_t i = 0; i + 1 < in.size(); i += 2)
+    /**
+     * @brief Demaps the Q15 symbols of the block exponent with integer decisions only: the level index of an axis
+     * is (v + L * a) / (2a) rounded down and clamped, a being the unit of the levels in the Q15 steps of the exponent,
+     * computed by a fixed-point reciprocal prepared once per call.
+     * @param in The symbols standing for in[n] / 2^15 * 2^exponent.
+     * @param exponent The block exponent of the symbols.
+     */
+    template <constellation Mod>
+    std::vector<uint8_t> from_constl(const std::vector<fixed::iq16>& in, int exponent, Mod m = {})
+    {
+        std::vector<uint8_t> out(in.size() * Mod::bits_per_symbol / 8);
+        utils::bit_writer writer(out.data());
+        if constexpr (Mod::bits_per_symbol == 1)
         {
-            uint8_t msb_sym = Mod::template nearest<T>(in[i]);
-            uint8_t lsb_sym = Mod::template nearest<T>(in[i + 1]);
-            // Pack two 4-bit symbols into one byte
-            out.push_back((msb_sym << 4) | (lsb_sym & 0xF));
+            for (const auto& v: in)
+                writer.write(v.re >= 0, 1);
         }
+        else
+        {
+            constexpr int64_t levels = Mod::levels;
+            const double unit = std::ldexp(Mod::template norm<double>, fixed::q15_bits - exponent);
+            const int64_t offset = std::llround(levels * unit);
+            const int64_t reciprocal = std::llround(std::ldexp(1.0, 32) / (2 * unit));
+            const auto slice = [offset, reciprocal](int16_t v) -> uint32_t
+            {
+                const int64_t index = ((v + offset) * reciprocal) >> 32;
+                return detail::gray(static_cast<uint32_t>(std::clamp<int64_t>(index, 0, levels - 1)));
+            };
 
+            for (const auto& v: in)
+                writer.write((slice(v.re) << Mod::axis_bits) | slice(v.im), Mod::bits_per_symbol);
+        }
+        writer.flush();
         return out;
     }
 }
\ No newline at end of file
@@ -0,0 +1,535 @@
+#pragma once
+
+#include "simd.hpp"
+#include <stdint.h>
+#include <complex>
+#include <concepts>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if SDR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace modulation::detail
+{
+    /**
+     * The decision thresholds of an axis of the square QAM: the level index of the normalized coordinate v
+     * is (v + offset) * scale clamped to [0, top] and rounded down. An add followed by a multiply,
+     * which no compiler fuses into a multiply-add, so the vector decisions are exactly the scalar ones.
+     */
+    template <std::floating_point T>
+    struct thresholds
+    {
+        T offset;
+        T scale;
+        T top;
+    };
+
+    template <std::floating_point T>
+    uint32_t level_index(T v, const thresholds<T>& t) noexcept
+    {
+        // max(0, x) and min(top, x) take the bound for NaN as the vector max/min do
+        return static_cast<uint32_t>(std::min(t.top, std::max(T{0}, (v + t.offset) * t.scale)));
+    }
+
+    /**
+     * @brief The hard decision of the interleaved (re, im) symbol: the sign of the real part for a single bit (BPSK),
+     * the Gray-coded level indices of the axes otherwise, the real one in the most significant half.
+     */
+    template <size_t Bits, std::floating_point T>
+    uint32_t decide(const T* p, const thresholds<T>& t) noexcept
+    {
+        if constexpr (Bits == 1)
+            return p[0] >= 0;
+        else
+        {
+            const uint32_t re = level_index(p[0], t);
+            const uint32_t im = level_index(p[1], t);
+            return ((re ^ (re >> 1)) << (Bits / 2)) | (im ^ (im >> 1));
+        }
+    }
+
+    /**
+     * @brief Packs 8 symbols of Bits bits into Bits bytes, the most significant bits first.
+     */
+    template <size_t Bits>
+    void pack8(const uint32_t* code, uint8_t* out) noexcept
+    {
+        constexpr size_t group = Bits <= 8 ? 8 : 4;     // the symbols fitting 64 bits in whole bytes
+        constexpr size_t bytes = group * Bits / 8;
+        for (size_t g = 0; g < 8; g += group, out += bytes)
+        {
+            uint64_t acc = 0;
+            for (size_t k = 0; k < group; ++k)
+                acc = (acc << Bits) | code[g + k];
+            for (size_t b = 0; b < bytes; ++b)
+                out[b] = static_cast<uint8_t>(acc >> (8 * (bytes - 1 - b)));
+        }
+    }
+
+    namespace scalar
+    {
+        /**
+         * A real register trait of a single value, the reference for the vector ones.
+         */
+        template <std::floating_point T>
+        struct fvec
+        {
+            using reg = T;
+            using ireg = size_t;
+            static constexpr size_t lanes = 1;
+
+            static reg set1(T v) { return v; }
+            static reg load(const T* p) { return *p; }
+            static void store(T* p, reg a) { *p = a; }
+            static void store(int8_t* p, reg a) { *p = static_cast<int8_t>(std::lrint(a)); }
+            static reg add(reg a, reg b) { return a + b; }
+            static reg mul(reg a, reg b) { return a * b; }
+            static reg madd(reg a, reg b, reg c) { return a * b + c; }
+            static reg min(reg a, reg b) { return a < b ? a : b; }
+            static reg max(reg a, reg b) { return a > b ? a : b; }
+            // Of the non-negative values: neither a libm call nor a branch on the baseline x86-64
+            static reg floor(reg a) { return static_cast<T>(static_cast<int64_t>(a)); }
+            static reg round(reg a) { return static_cast<T>(std::lrint(a)); }
+            static ireg index(reg a) { return static_cast<size_t>(a); }
+            static reg permute(reg a, ireg) { return a; }
+            template <size_t N>
+            static reg lookup(const T* table, ireg i) { return table[i]; }
+        };
+
+        #include "modulation_llr.hpp"
+
+        /**
+         * @brief The hard decisions of the interleaved symbols, the reference for the vector kernels.
+         * @param count The number of the symbols, a multiple of 8.
+         */
+        template <size_t Bits, std::floating_point T>
+        void hard_decisions(const T* x, size_t count, uint8_t* out, const thresholds<T>& t)
+        {
+            uint32_t code[8];
+            for (size_t n = 0; n < count; n += 8, x += 16, out += Bits)
+            {
+                for (size_t k = 0; k < 8; ++k)
+                    code[k] = decide<Bits>(x + 2 * k, t);
+                pack8<Bits>(code, out);
+            }
+        }
+    }
+
+#if SDR_SIMD_X86
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+    namespace avx2
+    {
+        template <std::floating_point T>
+        struct fvec;
+
+        template <>
+        struct fvec<float>
+        {
+            using reg = __m256;
+            using ireg = __m256i;
+            static constexpr size_t lanes = 8;
+
+            static reg set1(float v) { return _mm256_set1_ps(v); }
+            static reg load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+            static void store(int8_t* p, reg a)
+            {
+                const __m256i i = _mm256_cvtps_epi32(a);
+                const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi16(w, w));
+            }
+            static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static reg madd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+            static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+            static reg floor(reg a) { return _mm256_floor_ps(a); }
+            static reg round(reg a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+            static ireg index(reg a) { return _mm256_cvttps_epi32(a); }
+            static reg permute(reg a, ireg i) { return _mm256_permutevar8x32_ps(a, i); }
+            // The registers of the table picked by the index bits above the lane ones, bit 3 to the sign of the blend
+            template <size_t N>
+            static reg lookup(const float* table, ireg i)
+            {
+                if constexpr (N <= lanes)
+                    return permute(load(table), i);
+                else if constexpr (N <= 4 * lanes)
+                {
+                    const reg lo = _mm256_blendv_ps(permute(load(table), i), permute(load(table + 8), i), _mm256_castsi256_ps(_mm256_slli_epi32(i, 28)));
+                    if constexpr (N <= 2 * lanes)
+                        return lo;
+                    const reg hi = _mm256_blendv_ps(permute(load(table + 16), i), permute(load(table + 24), i), _mm256_castsi256_ps(_mm256_slli_epi32(i, 28)));
+                    return _mm256_blendv_ps(lo, hi, _mm256_castsi256_ps(_mm256_slli_epi32(i, 27)));
+                }
+                else
+                    return _mm256_i32gather_ps(table, i, 4);
+            }
+        };
+
+        template <>
+        struct fvec<double>
+        {
+            using reg = __m256d;
+            using ireg = __m256i;   // the halves 2i and 2i + 1 of the double i in every 64-bit lane, for the float permute
+            static constexpr size_t lanes = 4;
+
+            static reg set1(double v) { return _mm256_set1_pd(v); }
+            static reg load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+            static void store(int8_t* p, reg a)
+            {
+                const __m128i i = _mm256_cvtpd_epi32(a);
+                const __m128i w = _mm_packs_epi32(i, i);
+                _mm_storeu_si32(p, _mm_packs_epi16(w, w));
+            }
+            static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+            static reg madd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+            static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+            static reg floor(reg a) { return _mm256_floor_pd(a); }
+            static reg round(reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+            static ireg index(reg a)
+            {
+                const __m256i i = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(a));
+                return _mm256_add_epi64(_mm256_or_si256(_mm256_slli_epi64(i, 1), _mm256_slli_epi64(i, 33)), _mm256_set1_epi64x(int64_t{1} << 32));
+            }
+            static reg permute(reg a, ireg i) { return _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(a), i)); }
+            // The registers of the table picked by the index bits above the lane ones, bit 3 of 2i to the sign of the blend
+            template <size_t N>
+            static reg lookup(const double* table, ireg i)
+            {
+                if constexpr (N <= lanes)
+                    return permute(load(table), i);
+                else if constexpr (N <= 4 * lanes)
+                {
+                    const reg lo = _mm256_blendv_pd(permute(load(table), i), permute(load(table + 4), i), _mm256_castsi256_pd(_mm256_slli_epi64(i, 60)));
+                    if constexpr (N <= 2 * lanes)
+                        return lo;
+                    const reg hi = _mm256_blendv_pd(permute(load(table + 8), i), permute(load(table + 12), i), _mm256_castsi256_pd(_mm256_slli_epi64(i, 60)));
+                    return _mm256_blendv_pd(lo, hi, _mm256_castsi256_pd(_mm256_slli_epi64(i, 59)));
+                }
+                else // 2i at the scale of 4 bytes
+                    return _mm256_i64gather_pd(table, _mm256_and_si256(i, _mm256_set1_epi64x(0xffffffff)), 4);
+            }
+        };
+
+        #include "modulation_llr.hpp"
+
+        /**
+         * @brief The per-axis decisions of the interleaved values, an int32 each: the sign bit or the Gray-coded level index.
+         */
+        template <size_t Bits>
+        inline __m256i decide(__m256 v, __m256 offset, __m256 scale, __m256 top)
+        {
+            if constexpr (Bits == 1)
+                return _mm256_srli_epi32(_mm256_castps_si256(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ)), 31);
+            else
+            {
+                const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(v, offset), scale), _mm256_setzero_ps()), top);
+                const __m256i i = _mm256_cvttps_epi32(a);
+                return _mm256_xor_si256(i, _mm256_srli_epi32(i, 1));
+            }
+        }
+
+        template <size_t Bits>
+        inline __m128i decide(__m256d v, __m256d offset, __m256d scale, __m256d top)
+        {
+            if constexpr (Bits == 1)
+                return _mm256_cvttpd_epi32(_mm256_and_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_GE_OQ), _mm256_set1_pd(1)));
+            else
+            {
+                const __m256d a = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_add_pd(v, offset), scale), _mm256_setzero_pd()), top);
+                const __m128i i = _mm256_cvttpd_epi32(a);
+                return _mm_xor_si128(i, _mm_srli_epi32(i, 1));
+            }
+        }
+
+        /**
+         * @brief The symbol codes of 8 symbols out of their axis decisions, (re, im) pairs in the 64-bit lanes of g0 and g1.
+         */
+        template <size_t Bits>
+        inline __m256i codes(__m256i g0, __m256i g1)
+        {
+            if constexpr (Bits != 1)
+            {
+                g0 = _mm256_or_si256(_mm256_slli_epi64(g0, Bits / 2), _mm256_srli_epi64(g0, 32));
+                g1 = _mm256_or_si256(_mm256_slli_epi64(g1, Bits / 2), _mm256_srli_epi64(g1, 32));
+            }
+            // The low halves of the lanes, in the order 0 1 4 5 2 3 6 7 within the 128-bit halves, then restored
+            const __m256 lo = _mm256_shuffle_ps(_mm256_castsi256_ps(g0), _mm256_castsi256_ps(g1), _MM_SHUFFLE(2, 0, 2, 0));
+            return _mm256_permute4x64_epi64(_mm256_castps_si256(lo), _MM_SHUFFLE(3, 1, 2, 0));
+        }
+
+        template <size_t Bits>
+        void hard_decisions(const float* x, size_t count, uint8_t* out, const thresholds<float>& t)
+        {
+            const __m256 offset = _mm256_set1_ps(t.offset), scale = _mm256_set1_ps(t.scale), top = _mm256_set1_ps(t.top);
+            alignas(32) uint32_t code[8];
+            for (size_t n = 0; n < count; n += 8, x += 16, out += Bits)
+            {
+                const __m256i g0 = decide<Bits>(_mm256_loadu_ps(x), offset, scale, top);
+                const __m256i g1 = decide<Bits>(_mm256_loadu_ps(x + 8), offset, scale, top);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(code), codes<Bits>(g0, g1));
+                pack8<Bits>(code, out);
+            }
+        }
+
+        template <size_t Bits>
+        void hard_decisions(const double* x, size_t count, uint8_t* out, const thresholds<double>& t)
+        {
+            const __m256d offset = _mm256_set1_pd(t.offset), scale = _mm256_set1_pd(t.scale), top = _mm256_set1_pd(t.top);
+            alignas(32) uint32_t code[8];
+            for (size_t n = 0; n < count; n += 8, x += 16, out += Bits)
+            {
+                const __m256i g0 = _mm256_set_m128i(decide<Bits>(_mm256_loadu_pd(x + 4), offset, scale, top),
+                                                    decide<Bits>(_mm256_loadu_pd(x), offset, scale, top));
+                const __m256i g1 = _mm256_set_m128i(decide<Bits>(_mm256_loadu_pd(x + 12), offset, scale, top),
+                                                    decide<Bits>(_mm256_loadu_pd(x + 8), offset, scale, top));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(code), codes<Bits>(g0, g1));
+                pack8<Bits>(code, out);
+            }
+        }
+    }
+    #pragma GCC pop_options
+
+    #pragma GCC push_options
+    #pragma GCC target("avx512f")
+    namespace avx512
+    {
+        template <std::floating_point T>
+        struct fvec;
+
+        template <>
+        struct fvec<float>
+        {
+            using reg = __m512;
+            using ireg = __m512i;
+            static constexpr size_t lanes = 16;
+
+            static reg set1(float v) { return _mm512_set1_ps(v); }
+            static reg load(const float* p) { return _mm512_loadu_ps(p); }
+            static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+            static void store(int8_t* p, reg a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm512_cvtsepi32_epi8(_mm512_cvtps_epi32(a))); }
+            static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+            static reg madd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+            static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+            static reg floor(reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+            static reg round(reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+            static ireg index(reg a) { return _mm512_cvttps_epi32(a); }
+            static reg permute(reg a, ireg i) { return _mm512_permutexvar_ps(i, a); }
+            template <size_t N>
+            static reg lookup(const float* table, ireg i)
+            {
+                if constexpr (N <= lanes)
+                    return permute(load(table), i);
+                else if constexpr (N <= 2 * lanes)
+                    return _mm512_permutex2var_ps(load(table), i, load(table + lanes));
+                else if constexpr (N <= 4 * lanes)
+                    return _mm512_mask_blend_ps(_mm512_test_epi32_mask(i, _mm512_set1_epi32(2 * lanes)),
+                                                _mm512_permutex2var_ps(load(table), i, load(table + lanes)),
+                                                _mm512_permutex2var_ps(load(table + 2 * lanes), i, load(table + 3 * lanes)));
+                else
+                    return _mm512_i32gather_ps(i, table, 4);
+            }
+        };
+
+        template <>
+        struct fvec<double>
+        {
+            using reg = __m512d;
+            using ireg = __m512i;
+            static constexpr size_t lanes = 8;
+
+            static reg set1(double v) { return _mm512_set1_pd(v); }
+            static reg load(const double* p) { return _mm512_loadu_pd(p); }
+            static void store(double* p, reg a) { _mm512_storeu_pd(p, a); }
+            static void store(int8_t* p, reg a)
+            {
+                const __m256i i = _mm512_cvtpd_epi32(a);
+                const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi16(w, w));
+            }
+            static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+            static reg madd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+            static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+            static reg floor(reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+            static reg round(reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+            static ireg index(reg a) { return _mm512_cvtepi32_epi64(_mm512_cvttpd_epi32(a)); }
+            static reg permute(reg a, ireg i) { return _mm512_permutexvar_pd(i, a); }
+            template <size_t N>
+            static reg lookup(const double* table, ireg i)
+            {
+                if constexpr (N <= lanes)
+                    return permute(load(table), i);
+                else if constexpr (N <= 2 * lanes)
+                    return _mm512_permutex2var_pd(load(table), i, load(table + lanes));
+                else if constexpr (N <= 4 * lanes)
+                    return _mm512_mask_blend_pd(_mm512_test_epi64_mask(i, _mm512_set1_epi64(2 * lanes)),
+                                                _mm512_permutex2var_pd(load(table), i, load(table + lanes)),
+                                                _mm512_permutex2var_pd(load(table + 2 * lanes), i, load(table + 3 * lanes)));
+                else
+                    return _mm512_i64gather_pd(i, table, 8);
+            }
+        };
+
+        #include "modulation_llr.hpp"
+
+        template <size_t Bits>
+        inline __m512i decide(__m512 v, __m512 offset, __m512 scale, __m512 top)
+        {
+            if constexpr (Bits == 1)
+                return _mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_GE_OQ), 1);
+            else
+            {
+                const __m512 a = _mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(_mm512_add_ps(v, offset), scale), _mm512_setzero_ps()), top);
+                const __m512i i = _mm512_cvttps_epi32(a);
+                return _mm512_xor_si512(i, _mm512_srli_epi32(i, 1));
+            }
+        }
+
+        template <size_t Bits>
+        inline __m256i decide(__m512d v, __m512d offset, __m512d scale, __m512d top)
+        {
+            if constexpr (Bits == 1)
+                return _mm512_cvttpd_epi32(_mm512_maskz_mov_pd(_mm512_cmp_pd_mask(v, _mm512_setzero_pd(), _CMP_GE_OQ), _mm512_set1_pd(1)));
+            else
+            {
+                const __m512d a = _mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(_mm512_add_pd(v, offset), scale), _mm512_setzero_pd()), top);
+                const __m256i i = _mm512_cvttpd_epi32(a);
+                return _mm256_xor_si256(i, _mm256_srli_epi32(i, 1));
+            }
+        }
+
+        /**
+         * @brief The symbol codes of 8 symbols out of their axis decisions, (re, im) pairs in the 64-bit lanes.
+         */
+        template <size_t Bits>
+        inline __m256i codes(__m512i g)
+        {
+            if constexpr (Bits != 1)
+                g = _mm512_or_si512(_mm512_slli_epi64(g, Bits / 2), _mm512_srli_epi64(g, 32));
+            return _mm512_cvtepi64_epi32(g);
+        }
+
+        template <size_t Bits>
+        void hard_decisions(const float* x, size_t count, uint8_t* out, const thresholds<float>& t)
+        {
+            const __m512 offset = _mm512_set1_ps(t.offset), scale = _mm512_set1_ps(t.scale), top = _mm512_set1_ps(t.top);
+            alignas(64) uint32_t code[16];
+            for (size_t n = 0; n < count; n += 16, x += 32, out += 2 * Bits)
+            {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(code), codes<Bits>(decide<Bits>(_mm512_loadu_ps(x), offset, scale, top)));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(code + 8), codes<Bits>(decide<Bits>(_mm512_loadu_ps(x + 16), offset, scale, top)));
+                pack8<Bits>(code, out);
+                pack8<Bits>(code + 8, out + Bits);
+            }
+        }
+
+        template <size_t Bits>
+        void hard_decisions(const double* x, size_t count, uint8_t* out, const thresholds<double>& t)
+        {
+            const __m512d offset = _mm512_set1_pd(t.offset), scale = _mm512_set1_pd(t.scale), top = _mm512_set1_pd(t.top);
+            alignas(64) uint32_t code[16];
+            for (size_t n = 0; n < count; n += 16, x += 32, out += 2 * Bits)
+            {
+                for (size_t h = 0; h < 2; ++h)
+                {
+                    const __m256i lo = decide<Bits>(_mm512_loadu_pd(x + 16 * h), offset, scale, top);
+                    const __m256i hi = decide<Bits>(_mm512_loadu_pd(x + 16 * h + 8), offset, scale, top);
+                    const __m512i g = _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(code + 8 * h), codes<Bits>(g));
+                }
+                pack8<Bits>(code, out);
+                pack8<Bits>(code + 8, out + Bits);
+            }
+        }
+    }
+    #pragma GCC pop_options
+#endif
+
+    /**
+     * @brief The hard decisions of the symbols packed into bytes, the most significant bits first:
+     * 8 symbols, i.e. Bits bytes, a step on AVX2 and 16 on AVX-512.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param in The symbols.
+     * @param count The number of the symbols, a multiple of 8.
+     * @param out Bits bytes per 8 symbols.
+     * @param t The thresholds of an axis, ignored for a single bit.
+     */
+    template <size_t Bits, std::floating_point T>
+    void hard_decisions(simd::isa set, const std::complex<T>* in, size_t count, uint8_t* out, const thresholds<T>& t)
+    {
+        const T* x = reinterpret_cast<const T*>(in);
+#if SDR_SIMD_X86
+        if constexpr (std::same_as<T, float> || std::same_as<T, double>)
+        {
+            switch (set)
+            {
+            case simd::isa::avx512:
+            {
+                const size_t head = count / 16 * 16;
+                avx512::hard_decisions<Bits>(x, head, out, t);
+                x += 2 * head;
+                out += head / 8 * Bits;
+                count -= head;
+                [[fallthrough]]; // the remaining 8 symbols, if any
+            }
+            case simd::isa::avx2:
+                avx2::hard_decisions<Bits>(x, count, out, t);
+                return;
+            default:
+                break;
+            }
+        }
+#endif
+        scalar::hard_decisions<Bits>(x, count, out, t);
+    }
+
+    /**
+     * @brief The max-log LLRs of the symbols, Bits per symbol: V::lanes / 2 symbols a step on the vector instruction sets,
+     * the remaining ones scalar.
+     *
+     * @param set The instruction set, must be supported by the CPU.
+     * @param in The symbols.
+     * @param count The number of the symbols.
+     * @param out Bits LLRs per symbol.
+     * @param t The thresholds of an axis, ignored for a single bit.
+     * @param gain The LLR of the unit squared distance in the level index units, of the unit real part for a single bit.
+     * @param step The int8 steps per unit LLR, ignored for the floating point output.
+     */
+    template <size_t Bits, typename O, std::floating_point T>
+    void soft_decisions(simd::isa set, const std::complex<T>* in, size_t count, O* out, const thresholds<T>& t, T gain, T step)
+    {
+        const T* x = reinterpret_cast<const T*>(in);
+        size_t head = 0;
+#if SDR_SIMD_X86
+        if constexpr (std::same_as<T, float> || std::same_as<T, double>)
+        {
+            switch (set)
+            {
+            case simd::isa::avx512:
+                head = count / (avx512::fvec<T>::lanes / 2) * (avx512::fvec<T>::lanes / 2);
+                avx512::soft_decisions<Bits, O, avx512::fvec<T>>(x, head, out, t, gain, step);
+                break;
+            case simd::isa::avx2:
+                head = count / (avx2::fvec<T>::lanes / 2) * (avx2::fvec<T>::lanes / 2);
+                avx2::soft_decisions<Bits, O, avx2::fvec<T>>(x, head, out, t, gain, step);
+                break;
+            default:
+                break;
+            }
+        }
+#endif
+        scalar::soft_decisions<Bits, O, scalar::fvec<T>>(x + 2 * head, count - head, out + head * Bits, t, gain, step);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+// No include guard on purpose: modulation_kernels.hpp includes this body once per instruction set,
+// inside the namespace and the target region of that instruction set.
+//
+// The kernels are written against a trait V of real registers of V::lanes values providing
+// set1/load/store (also to int8, rounding to the nearest even), add/mul/madd, min(a, b)/max(a, b) taking b when a is NaN,
+// floor of non-negative values, round to the nearest even, index of the non-negative integral values, permute of
+// the lanes of a register by an index and lookup<N> of the entries of a table of N values, padded to 4 * V::lanes.
+
+/**
+ * @brief The max-log log-likelihood ratios ln P(b = 0) / P(b = 1) of the bits of the interleaved symbols,
+ * an axis value a lane. Within the decision region of the nearest level i, the nearest level of the other value
+ * of a bit is the same: it is next to the run of the Gray code holding i, and the runs not at the edges are of
+ * an even length, so the nearer side changes at a region boundary only. The difference of the squared distances
+ * is thus linear in the coordinate z there, and a bit is a lookup of the slope and the offset of (i, bit) and
+ * a multiply-add, exactly the max-log value. The lanes are spread to the output order by a permute per register,
+ * so the LLRs of a symbol are written contiguously with no transpose.
+ *
+ * @tparam O The output: T, or int8_t for the LLRs scaled by step, rounded and saturated to [-127, 127].
+ * @param x The interleaved symbols.
+ * @param count The number of the symbols, 2 * count being a multiple of V::lanes.
+ * @param out The LLRs, Bits per symbol in the order of the symbol bits, the most significant first.
+ * @param t The thresholds of an axis, unused for a single bit.
+ * @param gain The LLR of the unit squared distance in the level index units, of the unit real part for a single bit.
+ * @param step The int8 steps per unit LLR, unused for the floating point output.
+ */
+template <size_t Bits, typename O, typename V, typename T>
+void soft_decisions(const T* x, size_t count, O* out, const thresholds<T>& t, T gain, T step)
+{
+    using reg = typename V::reg;
+    constexpr bool quantized = std::same_as<O, int8_t>;
+    const reg limit = V::set1(127), minus_limit = V::set1(-127);
+
+    if constexpr (Bits == 1)
+    {
+        // The real parts only, every other lane
+        const reg g = V::set1(quantized ? gain * step : gain);
+        alignas(64) T llr[V::lanes];
+        for (size_t a = 0; a < 2 * count; a += V::lanes, x += V::lanes)
+        {
+            reg v = V::mul(V::load(x), g);
+            if constexpr (quantized)
+                v = V::round(V::min(V::max(v, minus_limit), limit));
+            V::store(llr, v);
+            for (size_t l = a % 2; l < V::lanes; l += 2) // odd a being of a single lane
+                out[(a + l) / 2] = static_cast<O>(llr[l]);
+        }
+    }
+    else
+    {
+        constexpr size_t axis_bits = Bits / 2;
+        constexpr size_t levels = size_t{1} << axis_bits;
+        constexpr size_t entries = levels * axis_bits;
+        const T unit = quantized ? gain * step : gain;
+
+        // The LLR of bit k in the region of level i is slope * z + offset, z in the level index units, level j at j + 1/2
+        alignas(64) T slope[std::max(entries, 4 * V::lanes)] = {};
+        alignas(64) T offset[std::max(entries, 4 * V::lanes)] = {};
+        const auto bit = [](size_t level, size_t k) { return ((level ^ (level >> 1)) >> (axis_bits - 1 - k)) & 1; };
+        for (size_t i = 0; i < levels; ++i)
+        {
+            for (size_t k = 0; k < axis_bits; ++k)
+            {
+                size_t lo = i, hi = i;  // the run of the bit value of i
+                while (lo > 0 && bit(lo - 1, k) == bit(i, k))
+                    --lo;
+                while (hi + 1 < levels && bit(hi + 1, k) == bit(i, k))
+                    ++hi;
+                const size_t other = lo == 0 ? hi + 1 : hi + 1 == levels || i - (lo - 1) < hi + 1 - i ? lo - 1 : hi + 1;
+                const T near = static_cast<T>(i) + T{0.5}, far = static_cast<T>(other) + T{0.5};
+                const T sign = bit(i, k) ? -unit : unit;
+                slope[i * axis_bits + k] = sign * 2 * (near - far);
+                offset[i * axis_bits + k] = sign * (far * far - near * near);
+            }
+        }
+
+        // The output register r of a step holds the positions r * lanes + l: the bit of the index modulo axis_bits
+        // of the axis of the index divided by axis_bits
+        typename V::ireg spread[axis_bits];
+        reg position[axis_bits];
+        for (size_t r = 0; r < axis_bits; ++r)
+        {
+            alignas(64) T axis[V::lanes], k[V::lanes];
+            for (size_t l = 0; l < V::lanes; ++l)
+            {
+                axis[l] = static_cast<T>((r * V::lanes + l) / axis_bits);
+                k[l] = static_cast<T>((r * V::lanes + l) % axis_bits);
+            }
+            spread[r] = V::index(V::load(axis));
+            position[r] = V::load(k);
+        }
+
+        const reg shift = V::set1(t.offset), scale = V::set1(t.scale), top = V::set1(t.top);
+        const reg zero = V::set1(0), per_level = V::set1(static_cast<T>(axis_bits));
+        for (size_t a = 0; a < 2 * count; a += V::lanes, x += V::lanes, out += V::lanes * axis_bits)
+        {
+            const reg z = V::mul(V::add(V::load(x), shift), scale);
+            const reg i = V::floor(V::min(V::max(z, zero), top)); // the nearest level
+            for (size_t r = 0; r < axis_bits; ++r)
+            {
+                const reg zr = axis_bits == 1 ? z : V::permute(z, spread[r]);
+                const reg ir = axis_bits == 1 ? i : V::permute(i, spread[r]);
+                const auto entry = V::index(V::madd(ir, per_level, position[r]));
+                reg llr = V::madd(V::template lookup<entries>(slope, entry), zr, V::template lookup<entries>(offset, entry));
+                if constexpr (quantized)
+                    llr = V::min(V::max(llr, minus_limit), limit); // the int8 store rounds
+                V::store(out + r * V::lanes, llr);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -2,8 +2,14 @@
 // 3.2 microsec symbol length
 // I.e. each carrier is deltaF=1/3.2 microsec=312.5kHz apart
 #include "fft.hpp"
+#include "fft_q15.hpp"
+#include "modulation.hpp"
+#include "subcarrier_map.hpp"
+#include <algorithm>
 #include <concepts>
 #include <expected>
+#include <format>
+#include <span>
 #include <vector>
 #include <complex>
 #include <stdint.h>
@@ -14,10 +20,15 @@ namespace ofdm
     std::expected<void, std::string> tx(const std::vector<std::complex<T>>& in, size_t cp_size, std::vector<std::complex<T>>& out)
     {
         out.resize(in.size() + cp_size);
-        std::copy(in.begin(), in.end(), out.begin() + cp_size);
-        return fft::ifft2(out.begin() + cp_size, out.end())
-            .and_then([&out, cp_size]() -> std::expected<void, std::string>
+        return fft::detail::cached_plan<T>(in.size(), fft::direction::inverse)
+            .and_then([&in, &out, cp_size](const fft::plan<T>* p)
+            {
+                return p->execute(in.begin(), in.end(), out.begin() + cp_size); // out of place, no extra copy for Stockham plans
+            })
+            .and_then([&out, cp_size, N = in.size()]() -> std::expected<void, std::string>
             {
+                for (auto it = out.begin() + cp_size; it != out.end(); ++it)
+                    *it /= N;
                 std::copy(out.end() - cp_size, out.end(), out.begin()); // guarding the start with a cyclic prefix
                 return {};
             });
@@ -34,12 +45,85 @@ namespace ofdm
             });
     }
 
+    /**
+     * @brief The in-place transmitter: the subcarriers are laid by the caller right after the prefix slot of `symbol`.
+     * The IFFT runs there in place and only the cyclic prefix is copied, with no pass copying the subcarriers in.
+     *
+     * @param symbol The buffer of N + cp samples: the subcarriers at [cp, cp + N) on input, the time-domain symbol
+     * prepended by the cyclic prefix on output.
+     * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> tx(std::span<std::complex<T>> symbol, size_t cp_size)
+    {
+        if (2 * cp_size > symbol.size())
+            return std::unexpected(std::format("The cyclic prefix size={} exceeds half of the buffer size={}", cp_size, symbol.size()));
+
+        const auto x = symbol.subspan(cp_size);
+        return fft::detail::cached_plan<T>(x.size(), fft::direction::inverse)
+            .and_then([x](const fft::plan<T>* p)
+            {
+                return p->execute(x.begin(), x.end());
+            })
+            .and_then([symbol, x, cp_size]() -> std::expected<void, std::string>
+            {
+                const T scale = T{1} / x.size();
+                for (auto& v: x)
+                    v *= scale;
+                std::copy(symbol.end() - cp_size, symbol.end(), symbol.begin()); // guarding the start with a cyclic prefix
+                return {};
+            });
+    }
+
+    /**
+     * @brief The fused transmitter: maps the packed symbols onto the subcarriers and modulates them into a time-domain
+     * symbol prepended by the cyclic prefix, touching every sample as few times as possible.
+     * Every constellation point is written straight to its bit-reversed (digit-reversed) position of the IFFT input in `out`,
+     * with the 1/N scaling folded into the constellation normalization. The butterflies then run in place and
+     * the prefix is copied from the tail after the transform. Allocates nothing once
+     * `out` has the capacity. The sizes of no input permutation (Bluestein, four-step) take the natural order instead.
+     *
+     * @param in The packed data, a subcarrier per bits_per_symbol bits.
+     * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+     * @param out The symbol, resized to fit.
+     */
+    template <modulation::constellation Mod, std::floating_point T>
+    std::expected<void, std::string> tx(const std::vector<uint8_t>& in, size_t cp_size, std::vector<std::complex<T>>& out, Mod m = {})
+    {
+        const size_t N = modulation::symbols<Mod>(in.size());
+        if (cp_size > N)
+            return std::unexpected(std::format("The cyclic prefix size={} exceeds the symbol size={}", cp_size, N));
+
+        out.resize(N + cp_size);
+        return fft::detail::cached_plan<T>(N, fft::direction::inverse)
+            .and_then([&in, &out, cp_size, N](const fft::plan<T>* p)
+            {
+                const auto& index = p->permutation();
+                const bool permuted = !index.empty();
+                const T scale = Mod::template norm<T> / static_cast<T>(N);
+                auto* x = out.data() + cp_size;
+                modulation::detail::for_each_symbol<Mod::bits_per_symbol>(in, [x, &index, permuted, scale](size_t n, uint32_t bits)
+                {
+                    x[permuted ? index[n] : n] = Mod::template table<T>[bits] * scale;
+                });
+                return permuted ? p->execute_permuted(x, x + N) : p->execute(x, x + N);
+            })
+            .and_then([&out, cp_size]() -> std::expected<void, std::string>
+            {
+                std::copy(out.end() - cp_size, out.end(), out.begin()); // guarding the start with a cyclic prefix
+                return {};
+            });
+    }
+
     template <std::floating_point T>
     std::expected<void, std::string> rx(const std::vector<std::complex<T>>& in, size_t cp_size, std::vector<std::complex<T>>& out)
     {
         out.resize(in.size() - cp_size);
-        std::copy(in.begin() + cp_size, in.end(), out.begin()); // throwing the cyclic prefix away
-        return fft::fft2(out.begin(), out.end());
+        return fft::detail::cached_plan<T>(out.size(), fft::direction::forward)
+            .and_then([&in, &out, cp_size](const fft::plan<T>* p)
+            {
+                return p->execute(in.begin() + cp_size, in.end(), out.begin()); // throwing the cyclic prefix away
+            });
     }
 
     template <std::floating_point T>
@@ -52,4 +136,359 @@ namespace ofdm
                 return out;
             });
     }
+
+    /**
+     * @brief The in-place receiver: skips the cyclic prefix by offset and runs the FFT on the caller's buffer.
+     *
+     * @param symbol The time-domain symbol prepended by the cyclic prefix, overwritten.
+     * @param cp_size The cyclic prefix size.
+     * @return std::expected<std::span<std::complex<T>>, std::string>
+     * - The subcarriers on success, the view of `symbol` past the cyclic prefix;
+     * - Error string on failure.
+     */
+    template <std::floating_point T>
+    std::expected<std::span<std::complex<T>>, std::string> rx(std::span<std::complex<T>> symbol, size_t cp_size)
+    {
+        if (cp_size > symbol.size())
+            return std::unexpected(std::format("The cyclic prefix size={} exceeds the symbol size={}", cp_size, symbol.size()));
+
+        const auto x = symbol.subspan(cp_size); // throwing the cyclic prefix away
+        return fft::detail::cached_plan<T>(x.size(), fft::direction::forward)
+            .and_then([x](const fft::plan<T>* p)
+            {
+                return p->execute(x.begin(), x.end());
+            })
+            .transform([x]()
+            {
+                return x;
+            });
+    }
+
+    /**
+     * @brief The transmitter of an allocation: lays the data and the pilots out on the bins right after the prefix slot
+     * of `symbol` in the same pass as zeroing the guard bands and the DC, then modulates the symbol in place.
+     *
+     * @param map The allocation of the subcarriers.
+     * @param data The data subcarriers, map.data_size() of them.
+     * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+     * @param symbol The time-domain symbol prepended by the cyclic prefix, map.size() + cp_size samples.
+     * @param polarity The sign of the pilots of the symbol.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> tx(const subcarrier_map& map, std::span<const std::complex<T>> data, size_t cp_size, std::span<std::complex<T>> symbol, std::type_identity_t<T> polarity = 1)
+    {
+        if (symbol.size() != map.size() + cp_size)
+            return std::unexpected(std::format("The symbol size={} does not fit the map size={} and the cyclic prefix size={}", symbol.size(), map.size(), cp_size));
+        return map.map(data, symbol.subspan(cp_size), polarity)
+            .and_then([symbol, cp_size]()
+            {
+                return tx(symbol, cp_size);
+            });
+    }
+
+    /**
+     * @brief The receiver of an allocation: demodulates the symbol in place and gathers the data subcarriers.
+     * The pilots stay in `symbol` past the cyclic prefix, e.g. for subcarrier_map::extract_pilots().
+     *
+     * @param map The allocation of the subcarriers.
+     * @param symbol The time-domain symbol prepended by the cyclic prefix, map.size() + cp_size samples, overwritten.
+     * @param cp_size The cyclic prefix size.
+     * @param data The data subcarriers, map.data_size() of them.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> rx(const subcarrier_map& map, std::span<std::complex<T>> symbol, size_t cp_size, std::span<std::complex<T>> data)
+    {
+        if (symbol.size() != map.size() + cp_size)
+            return std::unexpected(std::format("The symbol size={} does not fit the map size={} and the cyclic prefix size={}", symbol.size(), map.size(), cp_size));
+        return rx(symbol, cp_size)
+            .and_then([&map, data](std::span<std::complex<T>> bins)
+            {
+                return map.extract(std::span<const std::complex<T>>(bins), data);
+            });
+    }
+
+    /**
+     * @brief Modulates the subcarriers in the split layout into a time-domain symbol prepended by the cyclic prefix.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> tx(const utils::split_buffer<T>& in, size_t cp_size, utils::split_buffer<T>& out)
+    {
+        const size_t N = in.size();
+        out.resize(N + cp_size);
+        std::copy(in.real().begin(), in.real().end(), out.real().begin() + cp_size);
+        std::copy(in.imag().begin(), in.imag().end(), out.imag().begin() + cp_size);
+        return fft::detail::cached_plan<T>(N, fft::direction::inverse)
+            .and_then([&out, cp_size](const fft::plan<T>* p)
+            {
+                return p->execute(out.real().subspan(cp_size), out.imag().subspan(cp_size));
+            })
+            .and_then([&out, cp_size, N]() -> std::expected<void, std::string>
+            {
+                const T scale = T{1} / N;
+                for (auto part: { out.real(), out.imag() })
+                {
+                    for (size_t n = cp_size; n < part.size(); ++n)
+                        part[n] *= scale;
+                    std::copy(part.end() - cp_size, part.end(), part.begin()); // guarding the start with a cyclic prefix
+                }
+                return {};
+            });
+    }
+
+    /**
+     * @brief Demodulates the time-domain symbol with the cyclic prefix into the subcarriers in the split layout.
+     */
+    template <std::floating_point T>
+    std::expected<void, std::string> rx(const utils::split_buffer<T>& in, size_t cp_size, utils::split_buffer<T>& out)
+    {
+        out.resize(in.size() - cp_size);
+        std::copy(in.real().begin() + cp_size, in.real().end(), out.real().begin()); // throwing the cyclic prefix away
+        std::copy(in.imag().begin() + cp_size, in.imag().end(), out.imag().begin());
+        return fft::fft2(out);
+    }
+
+    /**
+     * @brief The fixed-point transmitter of the raw int16 IQ: maps the packed symbols onto the subcarriers in Q15
+     * straight into `out`, runs the block-floating-point IFFT in place and prepends the cyclic prefix;
+     * the 1/N scaling only lowers the reported block exponent. Power of 2 symbol sizes only.
+     *
+     * @param in The packed data, a subcarrier per bits_per_symbol bits.
+     * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+     * @param out The symbol, resized to fit.
+     * @return std::expected<int, std::string>
+     * - The block exponent of the symbol on success: the samples stand for out[n] / 2^15 * 2^exponent;
+     * - Error string on failure.
+     */
+    template <modulation::constellation Mod>
+    std::expected<int, std::string> tx(const std::vector<uint8_t>& in, size_t cp_size, std::vector<fixed::iq16>& out, Mod m = {})
+    {
+        const size_t N = modulation::symbols<Mod>(in.size());
+        if (cp_size > N)
+            return std::unexpected(std::format("The cyclic prefix size={} exceeds the symbol size={}", cp_size, N));
+
+        out.resize(N + cp_size);
+        return fft::detail::cached<fft::q15_plan>(N, fft::direction::inverse)
+            .and_then([&in, &out, cp_size, N](const fft::q15_plan* p)
+            {
+                constexpr int exponent = modulation::detail::q15_exponent_v<Mod>;
+                auto x = std::span(out).subspan(cp_size);
+                modulation::detail::for_each_symbol<Mod::bits_per_symbol>(in, [x](size_t n, uint32_t bits)
+                {
+                    x[n] = fixed::to_iq16(Mod::template table<double>[bits] * std::ldexp(Mod::template norm<double>, -exponent));
+                });
+                return p->execute(x, exponent);
+            })
+            .transform([&out, cp_size, N](int exponent)
+            {
+                std::copy(out.end() - cp_size, out.end(), out.begin()); // guarding the start with a cyclic prefix
+                return exponent - std::countr_zero(N);
+            });
+    }
+
+    /**
+     * @brief The fixed-point receiver of the raw int16 IQ: throws the cyclic prefix away and runs the block-floating-point FFT.
+     *
+     * @param in The symbol with the cyclic prefix, a power of 2 samples without it.
+     * @param cp_size The cyclic prefix size.
+     * @param out The subcarriers, resized to fit.
+     * @param exponent The block exponent of the symbol.
+     * @return std::expected<int, std::string>
+     * - The block exponent of the subcarriers on success;
+     * - Error string on failure.
+     */
+    inline std::expected<int, std::string> rx(std::span<const fixed::iq16> in, size_t cp_size, std::vector<fixed::iq16>& out, int exponent = 0)
+    {
+        if (cp_size > in.size())
+            return std::unexpected(std::format("The cyclic prefix size={} exceeds the symbol size={}", cp_size, in.size()));
+
+        out.assign(in.begin() + cp_size, in.end());
+        return fft::fft2(std::span(out), exponent);
+    }
+
+    /**
+     * A stateful OFDM modulator of whole frames, configured once with the number of the subcarriers N, the cyclic prefix
+     * and the IFFT plan. The frame of K symbols is laid out contiguously, K * (N + cp) samples, in a buffer kept across
+     * the calls: a stream of equal frames allocates nothing after the first one. The K IFFTs run as one in-place batch
+     * straight in the frame, the symbols N + cp apart, split across threads when large.
+     */
+    template <std::floating_point T>
+    class modulator
+    {
+    public:
+        /**
+         * @brief Creates the modulator.
+         *
+         * @param size The number of the subcarriers, the IFFT size.
+         * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+         * @param set Instruction set of the IFFT, the widest one supported by the CPU by default.
+         * @return std::expected<modulator, std::string>
+         * - The modulator on success;
+         * - Error string on failure.
+         */
+        static std::expected<modulator, std::string> create(size_t size, size_t cp_size, simd::isa set = simd::detect())
+        {
+            if (size == 0 || cp_size > size)
+                return std::unexpected(std::format("The cyclic prefix size={} does not suit the symbol size={}", cp_size, size));
+            return fft::plan<T>::create(size, fft::direction::inverse, set)
+                .transform([cp_size](fft::plan<T>&& p)
+                {
+                    return modulator(std::move(p), cp_size);
+                });
+        }
+
+        /**
+         * @brief Modulates a frame: every N subcarriers into a time-domain symbol prepended by its cyclic prefix.
+         *
+         * @param in The subcarriers of K symbols.
+         * @return std::expected<std::span<const std::complex<T>>, std::string>
+         * - The frame of K * (N + cp) samples on success, valid until the next call;
+         * - Error string on failure, e.g. the subcarriers are not a whole number of symbols.
+         */
+        std::expected<std::span<const std::complex<T>>, std::string> process(std::span<const std::complex<T>> in)
+        {
+            const size_t N = plan_.size();
+            const size_t L = N + cp_size_;
+            if (in.size() % N != 0)
+                return std::unexpected(std::format("The {} subcarriers are not a whole number of symbols of size={}", in.size(), N));
+
+            const size_t K = in.size() / N;
+            frame_.resize(K * L);
+            const T scale = T{1} / static_cast<T>(N);
+            for (size_t k = 0; k < K; ++k)
+                std::transform(in.begin() + k * N, in.begin() + (k + 1) * N, frame_.begin() + k * L + cp_size_, [scale](const std::complex<T>& v)
+                {
+                    return v * scale; // the 1/N scaling folded into the copy
+                });
+
+            return plan_.execute_batch(frame_.begin() + cp_size_, K, fft::layout::contiguous, L)
+                .transform([this, K, L, N]()
+                {
+                    for (size_t k = 0; k < K; ++k) // guarding the starts with the cyclic prefixes
+                        std::copy(frame_.begin() + k * L + N, frame_.begin() + (k + 1) * L, frame_.begin() + k * L);
+                    return std::span<const std::complex<T>>(frame_);
+                });
+        }
+
+        /**
+         * @brief Maps the packed data onto the subcarriers and modulates them, the last symbol padded with zero subcarriers.
+         *
+         * @param in The packed data, a subcarrier per bits_per_symbol bits.
+         * @return The frame as of process().
+         */
+        template <modulation::constellation Mod>
+        std::expected<std::span<const std::complex<T>>, std::string> transmit(std::span<const uint8_t> in, Mod m = {})
+        {
+            const size_t N = plan_.size();
+            symbols_.assign((modulation::symbols<Mod>(in.size()) + N - 1) / N * N, std::complex<T>{});
+            modulation::to_constl<Mod, T>(in, symbols_.begin());
+            return process(symbols_);
+        }
+
+        size_t size() const noexcept { return plan_.size(); }
+        size_t cp_size() const noexcept { return cp_size_; }
+
+    private:
+        modulator(fft::plan<T>&& p, size_t cp_size)
+            : plan_(std::move(p))
+            , cp_size_(cp_size) {}
+
+        fft::plan<T>                    plan_;
+        size_t                          cp_size_;
+        std::vector<std::complex<T>>    frame_;
+        std::vector<std::complex<T>>    symbols_;
+    };
+
+    /**
+     * A stateful OFDM demodulator of whole frames, the counterpart of the modulator: throws the cyclic prefixes away
+     * into the subcarrier buffer kept across the calls and runs the K FFTs there as one in-place batch.
+     */
+    template <std::floating_point T>
+    class demodulator
+    {
+    public:
+        /**
+         * @brief Creates the demodulator.
+         *
+         * @param size The number of the subcarriers, the FFT size.
+         * @param cp_size The cyclic prefix size, at most the number of the subcarriers.
+         * @param set Instruction set of the FFT, the widest one supported by the CPU by default.
+         * @return std::expected<demodulator, std::string>
+         * - The demodulator on success;
+         * - Error string on failure.
+         */
+        static std::expected<demodulator, std::string> create(size_t size, size_t cp_size, simd::isa set = simd::detect())
+        {
+            if (size == 0 || cp_size > size)
+                return std::unexpected(std::format("The cyclic prefix size={} does not suit the symbol size={}", cp_size, size));
+            return fft::plan<T>::create(size, fft::direction::forward, set)
+                .transform([cp_size](fft::plan<T>&& p)
+                {
+                    return demodulator(std::move(p), cp_size);
+                });
+        }
+
+        /**
+         * @brief Demodulates a frame of K symbols, each prepended by its cyclic prefix.
+         *
+         * @param in The frame of K * (N + cp) samples.
+         * @return std::expected<std::span<const std::complex<T>>, std::string>
+         * - The K * N subcarriers on success, valid until the next call;
+         * - Error string on failure, e.g. the samples are not a whole number of symbols.
+         */
+        std::expected<std::span<const std::complex<T>>, std::string> process(std::span<const std::complex<T>> in)
+        {
+            const size_t N = plan_.size();
+            const size_t L = N + cp_size_;
+            if (in.size() % L != 0)
+                return std::unexpected(std::format("The {} samples are not a whole number of symbols of size={}", in.size(), L));
+
+            const size_t K = in.size() / L;
+            symbols_.resize(K * N);
+            for (size_t k = 0; k < K; ++k) // throwing the cyclic prefixes away
+                std::copy(in.begin() + k * L + cp_size_, in.begin() + (k + 1) * L, symbols_.begin() + k * N);
+
+            return plan_.execute_batch(symbols_.begin(), K)
+                .transform([this]()
+                {
+                    return std::span<const std::complex<T>>(symbols_);
+                });
+        }
+
+        /**
+         * @brief Demodulates a frame and demaps the subcarriers into the packed data.
+         *
+         * @param in The frame of K * (N + cp) samples.
+         * @return std::expected<std::span<const uint8_t>, std::string>
+         * - The data of all the K * N subcarriers on success, valid until the next call; the padding of the transmitter
+         *   comes out as well, the caller knows the payload size;
+         * - Error string on failure.
+         */
+        template <modulation::constellation Mod>
+        std::expected<std::span<const uint8_t>, std::string> receive(std::span<const std::complex<T>> in, Mod m = {})
+        {
+            return process(in)
+                .and_then([this](std::span<const std::complex<T>> symbols)
+                {
+                    bytes_.resize(symbols.size() * Mod::bits_per_symbol / 8);
+                    return modulation::from_constl<Mod, T>(symbols, std::span(bytes_));
+                })
+                .transform([this](size_t count)
+                {
+                    return std::span<const uint8_t>(bytes_.data(), count);
+                });
+        }
+
+        size_t size() const noexcept { return plan_.size(); }
+        size_t cp_size() const noexcept { return cp_size_; }
+
+    private:
+        demodulator(fft::plan<T>&& p, size_t cp_size)
+            : plan_(std::move(p))
+            , cp_size_(cp_size) {}
+
+        fft::plan<T>                    plan_;
+        size_t                          cp_size_;
+        std::vector<std::complex<T>>    symbols_;
+        std::vector<uint8_t>            bytes_;
+    };
 }
\ No newline at end of file
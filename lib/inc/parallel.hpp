@@ -0,0 +1,199 @@
+#pragma once
+
+// The backend is chosen by the SDR_PARALLEL_BACKEND CMake option:
+// - threads (default), an internal pool of persistent threads claiming the chunks dynamically;
+// - openmp, SDR_PARALLEL_OPENMP defined and OpenMP linked;
+// - none, SDR_PARALLEL_NONE defined, everything runs on the calling thread.
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#if defined(SDR_PARALLEL_OPENMP)
+#include <omp.h>
+#endif
+
+namespace parallel
+{
+    enum class backend
+    {
+        none,
+        openmp,
+        threads
+    };
+
+#if defined(SDR_PARALLEL_NONE)
+    inline constexpr backend active = backend::none;
+#elif defined(SDR_PARALLEL_OPENMP)
+    inline constexpr backend active = backend::openmp;
+#else
+    inline constexpr backend active = backend::threads;
+#endif
+
+    /**
+     * @brief The number of threads the work is split across.
+     */
+    inline size_t concurrency() noexcept
+    {
+#if defined(SDR_PARALLEL_NONE)
+        return 1;
+#elif defined(SDR_PARALLEL_OPENMP)
+        return static_cast<size_t>(std::max(1, omp_get_max_threads()));
+#else
+        static const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        return threads;
+#endif
+    }
+
+    namespace detail
+    {
+        /**
+         * A pool of concurrency() - 1 persistent threads; the submitting thread makes the last one.
+         * A job is a number of tasks the threads claim one by one from a shared counter, so that
+         * the faster threads take over the work of the slower ones. The calls from inside a task run inline.
+         */
+        class pool
+        {
+        public:
+            static pool& instance()
+            {
+                static pool p(concurrency() - 1);
+                return p;
+            }
+
+            /**
+             * @brief Runs fn(task) for every task in [0, tasks) and returns when all of them are done.
+             * @param fn The task processor, must be safe to call concurrently and must not throw.
+             */
+            template <typename F>
+            void run(size_t tasks, F& fn)
+            {
+                if (workers_.empty() || inside_)
+                {
+                    for (size_t t = 0; t < tasks; ++t)
+                        fn(t);
+                    return;
+                }
+
+                std::lock_guard submit(submit_); // One job at a time
+                job j
+                {
+                    .call = [](void* f, size_t t) { (*static_cast<F*>(f))(t); },
+                    .fn = &fn,
+                    .tasks = tasks
+                };
+                {
+                    std::lock_guard lock(mutex_);
+                    job_ = &j;
+                    ++generation_;
+                }
+                wake_.notify_all();
+
+                inside_ = true;
+                work(j);
+                inside_ = false;
+
+                std::unique_lock lock(mutex_);
+                job_ = nullptr; // No thread joins the job anymore, wait for the ones still in it
+                done_.wait(lock, [&j]() { return j.users == 0; });
+            }
+
+        private:
+            struct job
+            {
+                void                (*call)(void*, size_t);
+                void*               fn;
+                size_t              tasks;
+                std::atomic<size_t> next{0};
+                size_t              users = 0; // Guarded by mutex_
+            };
+
+            explicit pool(size_t threads)
+            {
+                workers_.reserve(threads);
+                for (size_t i = 0; i < threads; ++i)
+                    workers_.emplace_back([this](std::stop_token stop) { loop(stop); });
+            }
+
+            static void work(job& j)
+            {
+                for (size_t t = j.next.fetch_add(1); t < j.tasks; t = j.next.fetch_add(1))
+                    j.call(j.fn, t);
+            }
+
+            void loop(std::stop_token stop)
+            {
+                inside_ = true;
+                size_t seen = 0;
+                for (;;)
+                {
+                    job* j = nullptr;
+                    {
+                        std::unique_lock lock(mutex_);
+                        if (!wake_.wait(lock, stop, [&]() { return job_ && generation_ != seen; }))
+                            return;
+                        seen = generation_;
+                        j = job_;
+                        ++j->users;
+                    }
+                    work(*j);
+                    {
+                        std::lock_guard lock(mutex_);
+                        --j->users;
+                    }
+                    done_.notify_all();
+                }
+            }
+
+            static inline thread_local bool inside_ = false;
+
+            std::mutex                  submit_;
+            std::mutex                  mutex_;
+            std::condition_variable_any wake_;
+            std::condition_variable     done_;
+            job*                        job_ = nullptr;
+            size_t                      generation_ = 0;
+            std::vector<std::jthread>   workers_; // Last, so that the threads stop before the rest is destroyed
+        };
+    }
+
+    /**
+     * @brief Splits the range [0, count) into contiguous chunks and processes them on separate threads.
+     * The calling thread takes part. Runs inline when the range holds less than two grains.
+     *
+     * @tparam F Callable as fn(size_t begin, size_t end).
+     * @param count Size of the range.
+     * @param grain The smallest chunk worth a thread.
+     * @param fn The chunk processor, must be safe to call concurrently for disjoint chunks.
+     */
+    template <typename F>
+    void for_range(size_t count, size_t grain, F&& fn)
+    {
+        const size_t threads = concurrency();
+        const size_t chunks  = std::min(threads, count / std::max<size_t>(grain, 1));
+        if (chunks < 2)
+        {
+            fn(size_t{0}, count);
+            return;
+        }
+
+#if defined(SDR_PARALLEL_OPENMP)
+        #pragma omp parallel for num_threads(chunks) schedule(static)
+        for (size_t c = 0; c < chunks; ++c)
+            fn(count * c / chunks, count * (c + 1) / chunks);
+#else
+        // A few chunks per thread let the pool balance the uneven progress of the threads
+        const size_t tasks = std::min(4 * threads, count / std::max<size_t>(grain, 1));
+        auto task = [&fn, tasks, count](size_t t)
+        {
+            fn(count * t / tasks, count * (t + 1) / tasks);
+        };
+        detail::pool::instance().run(tasks, task);
+#endif
+    }
+}
\ No newline at end of file
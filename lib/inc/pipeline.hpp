@@ -0,0 +1,293 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <expected>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace parallel
+{
+    /**
+     * A bounded lock-free queue of a single producer and a single consumer: a ring of a power of 2 slots indexed by
+     * the running push and pop counters, each on its own cache line with the copy of the other one, so that a push
+     * or a pop touches the shared line only when its copy runs out. A full push and an empty pop block on the counter
+     * of the other side with the atomic wait, which is the backpressure. The top bit of the counters tells that
+     * the producer has closed the queue or the consumer has abandoned it, waking the other side too.
+     */
+    template <typename T>
+    class spsc_queue
+    {
+    public:
+        explicit spsc_queue(size_t capacity)
+            : slots_(std::bit_ceil(std::max<size_t>(capacity, 2)))
+            , mask_(slots_.size() - 1) {}
+
+        /**
+         * @brief Pushes the item, waiting while the queue is full.
+         * @return false when the consumer has abandoned the queue, the item being dropped.
+         */
+        bool push(T&& item)
+        {
+            const uint64_t tail = producer_.own;
+            while (tail - producer_.other >= slots_.size())
+            {
+                const uint64_t head = consumer_.own_shared.load(std::memory_order_acquire);
+                if (head & flag)
+                    return false;
+                producer_.other = head;
+                if (tail - head >= slots_.size())
+                    consumer_.own_shared.wait(head, std::memory_order_acquire);
+            }
+            slots_[tail & mask_] = std::move(item);
+            producer_.own = tail + 1;
+            producer_.own_shared.store(tail + 1, std::memory_order_release);
+            producer_.own_shared.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Pops the next item, waiting while the queue is empty.
+         * @return The item or nothing when the queue is closed and empty.
+         */
+        std::optional<T> pop()
+        {
+            const uint64_t head = consumer_.own;
+            while (head == consumer_.other)
+            {
+                const uint64_t tail = producer_.own_shared.load(std::memory_order_acquire);
+                if ((tail & ~flag) != head)
+                    consumer_.other = tail & ~flag;
+                else if (tail & flag)
+                    return std::nullopt;
+                else
+                    producer_.own_shared.wait(tail, std::memory_order_acquire);
+            }
+            std::optional<T> item(std::move(slots_[head & mask_]));
+            consumer_.own = head + 1;
+            consumer_.own_shared.store(head + 1, std::memory_order_release);
+            consumer_.own_shared.notify_one();
+            return item;
+        }
+
+        // The producer's end of the stream: pop() drains the queue and returns nothing then
+        void close()
+        {
+            producer_.own_shared.fetch_or(flag, std::memory_order_release);
+            producer_.own_shared.notify_one();
+        }
+
+        // The consumer's end of the stream: push() fails once it runs out of the room it has already seen
+        void abandon()
+        {
+            consumer_.own_shared.fetch_or(flag, std::memory_order_release);
+            consumer_.own_shared.notify_one();
+        }
+
+        size_t capacity() const noexcept { return slots_.size(); }
+
+    private:
+        static constexpr uint64_t flag = uint64_t{1} << 63;
+
+        // The counter of a side: the published one, the private copy and the last seen counter of the other side
+        struct alignas(64) side
+        {
+            std::atomic<uint64_t>   own_shared{0};
+            uint64_t                own = 0;
+            uint64_t                other = 0;
+        };
+
+        std::vector<T>  slots_;
+        size_t          mask_;
+        side            producer_;
+        side            consumer_;
+    };
+
+    /**
+     * A processing pipeline of batches: every stage runs on its own thread, optionally pinned to a core, and passes
+     * the batch it has processed to the next one through a bounded spsc_queue. The stages of a batch thus overlap
+     * with the ones of its neighbours, and the throughput is bound by the slowest stage instead of their sum;
+     * a full queue stalls the stages behind it. Every stage counts its batches and the time spent processing them.
+     */
+    template <typename T>
+    class pipeline
+    {
+    public:
+        struct stage
+        {
+            std::string                 name;
+            std::function<void(T&)>     fn;     // processes a batch in place, must not throw
+        };
+
+        struct stage_stats
+        {
+            std::string                 name;
+            uint64_t                    batches;
+            std::chrono::nanoseconds    busy;   // the time spent in the stage function
+
+            // The batches per second of the stage alone
+            double throughput() const noexcept
+            {
+                return busy.count() > 0 ? batches * 1e9 / busy.count() : 0.0;
+            }
+        };
+
+        /**
+         * @brief Creates the pipeline and starts its threads.
+         *
+         * @param stages The stages in the order of processing.
+         * @param depth The batches a queue between two stages holds, rounded up to a power of 2.
+         * @param pin Pins the thread of the stage i to the core i modulo the number of the cores, Linux only.
+         * @return std::expected<pipeline, std::string>
+         * - The pipeline on success;
+         * - Error string on failure.
+         */
+        static std::expected<pipeline, std::string> create(std::vector<stage> stages, size_t depth = 8, bool pin = false)
+        {
+            if (stages.empty())
+                return std::unexpected("The pipeline has no stages");
+            if (depth == 0)
+                return std::unexpected("The queue depth must be positive");
+            return pipeline(std::move(stages), depth, pin);
+        }
+
+        pipeline(pipeline&&) noexcept = default;
+
+        pipeline& operator=(pipeline&& other) noexcept
+        {
+            if (this != &other)
+            {
+                stop();
+                state_ = std::move(other.state_);
+            }
+            return *this;
+        }
+
+        ~pipeline()
+        {
+            stop();
+        }
+
+        /**
+         * @brief Feeds the batch into the first stage, waiting while the pipeline is full.
+         * @return false when the pipeline is stopped.
+         */
+        bool push(T batch)
+        {
+            return state_->queues.front()->push(std::move(batch));
+        }
+
+        /**
+         * @brief Takes the next batch out of the last stage, waiting for it.
+         * @return The batch or nothing when the input is closed and everything processed.
+         */
+        std::optional<T> pop()
+        {
+            return state_->queues.back()->pop();
+        }
+
+        // Ends the input: the stages process the batches in flight and pop() returns nothing then
+        void close()
+        {
+            state_->queues.front()->close();
+        }
+
+        std::vector<stage_stats> stats() const
+        {
+            std::vector<stage_stats> out;
+            for (const auto& s: state_->stages)
+                out.push_back({ s.name, s.batches.load(std::memory_order_relaxed), std::chrono::nanoseconds(s.busy.load(std::memory_order_relaxed)) });
+            return out;
+        }
+
+    private:
+        struct running_stage
+        {
+            std::string                 name;
+            std::function<void(T&)>     fn;
+            std::atomic<uint64_t>       batches{0};
+            std::atomic<int64_t>        busy{0};    // nanoseconds
+        };
+
+        struct state
+        {
+            std::vector<running_stage>                  stages;
+            std::vector<std::unique_ptr<spsc_queue<T>>> queues;     // queues[i] feeds stages[i], the last one is the output
+            std::vector<std::thread>                    threads;
+        };
+
+        pipeline(std::vector<stage> stages, size_t depth, bool pin)
+            : state_(std::make_unique<state>())
+        {
+            state_->stages = std::vector<running_stage>(stages.size());
+            for (size_t i = 0; i < stages.size(); ++i)
+            {
+                state_->stages[i].name = std::move(stages[i].name);
+                state_->stages[i].fn = std::move(stages[i].fn);
+            }
+            for (size_t i = 0; i <= stages.size(); ++i)
+                state_->queues.push_back(std::make_unique<spsc_queue<T>>(depth));
+
+            const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < stages.size(); ++i)
+            {
+                state_->threads.emplace_back(run, std::ref(state_->stages[i]), std::ref(*state_->queues[i]), std::ref(*state_->queues[i + 1]));
+#if defined(__linux__)
+                if (pin)
+                {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(i % cores, &set);
+                    pthread_setaffinity_np(state_->threads.back().native_handle(), sizeof(set), &set);
+                }
+#endif
+            }
+        }
+
+        // Stops the stages: closes the input and abandons the output, the ends this thread owns. The batches in flight
+        // are dropped once they meet the abandoned queue, the stages before it possibly processing a few more first
+        void stop()
+        {
+            if (!state_)
+                return;
+            state_->queues.front()->close();
+            state_->queues.back()->abandon();
+            for (auto& t: state_->threads)
+                t.join();
+            state_.reset();
+        }
+
+        static void run(running_stage& s, spsc_queue<T>& in, spsc_queue<T>& out)
+        {
+            while (auto batch = in.pop())
+            {
+                const auto start = std::chrono::steady_clock::now();
+                s.fn(*batch);
+                const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                s.busy.fetch_add(busy.count(), std::memory_order_relaxed);
+                s.batches.fetch_add(1, std::memory_order_relaxed);
+                if (!out.push(std::move(*batch)))
+                    break;
+            }
+            // Passing the end downstream and the stop upstream
+            out.close();
+            in.abandon();
+        }
+
+        std::unique_ptr<state>  state_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "fft.hpp"
+#include <stdint.h>
+#include <iterator>
+#include <complex>
+#include <numbers>
+#include <concepts>
+#include <expected>
+#include <string>
+#include <format>
+#include <vector>
+
+namespace fft
+{
+    /**
+     * @brief Checks whether an iterator belongs to a contiguous container of real floating-point values.
+     */
+    template <typename It>
+    concept rfft_compatible_iterator = std::contiguous_iterator<It>
+                                    && std::floating_point<std::iter_value_t<It>>;
+
+    /**
+     * @brief A precomputed FFT of real sequences.
+     * N reals are packed into N/2 complex numbers as z[n] = x[2n] + i*x[2n + 1], transformed by the complex
+     * FFT of N/2 points and split into the Hermitian half-spectrum X[0..N/2]. The negative frequencies
+     * are the conjugates of the positive ones, hence never stored. Roughly halves the time and memory
+     * compared to the complex FFT of the widened sequence.
+     *
+     * @tparam T double or float.
+     */
+    template <std::floating_point T>
+    class real_plan
+    {
+    public:
+        /**
+         * @brief Creates the plan.
+         *
+         * @param size Size of the real sequences, even.
+         * @param dir forward for the reals -> half-spectrum transform, inverse for the scaled half-spectrum -> reals one.
+         * @param set Instruction set of the butterfly kernels, the widest one supported by the CPU by default.
+         * @return std::expected<real_plan, std::string>
+         * - The plan on success;
+         * - Error string on failure.
+         */
+        static std::expected<real_plan, std::string> create(size_t size, direction dir = direction::forward, simd::isa set = simd::detect())
+        {
+            if (size < 2 || size % 2 != 0)
+                return std::unexpected("The real sequence size must be even and at least 2");
+
+            return plan<T>::create(size / 2, dir, set)
+                .transform([size](plan<T>&& half)
+                {
+                    real_plan p(std::move(half));
+                    p.size_ = size;
+
+                    // w(N)^k of the forward transform for k in [0, N/4]
+                    p.twiddles_.resize(size / 4 + 1);
+                    for (size_t k = 0; k < p.twiddles_.size(); ++k)
+                    {
+                        const long double theta = -2.0L * std::numbers::pi_v<long double> * k / size;
+                        p.twiddles_[k] = { static_cast<T>(std::cos(theta)), static_cast<T>(std::sin(theta)) };
+                    }
+                    return p;
+                });
+        }
+
+        /**
+         * @brief Forward plan: transforms N reals into N/2 + 1 complex bins.
+         *
+         * @param begin The real sequence begin iterator.
+         * @param end The real sequence end iterator.
+         * @param out The begin iterator of the N/2 + 1 bins; also serves as the work area, no scratch is allocated.
+         * @return std::expected<void, std::string>
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        template <rfft_compatible_iterator It, std::contiguous_iterator Out>
+            requires std::same_as<std::iter_value_t<It>, T> && std::same_as<std::iter_value_t<Out>, std::complex<T>>
+        std::expected<void, std::string> execute(It begin, It end, Out out) const
+        {
+            if (half_.dir() != direction::forward)
+                return std::unexpected("The plan is not of the forward direction");
+            if (static_cast<size_t>(std::distance(begin, end)) != size_)
+                return std::unexpected(std::format("The sequence size does not match the plan size={}", size_));
+
+            const T*         x = std::to_address(begin);
+            std::complex<T>* z = std::to_address(out);
+            const size_t     M = size_ / 2;
+
+            for (size_t n = 0; n < M; ++n) // Packing the even samples into the real parts and the odd ones into the imaginary
+                z[n] = { x[2 * n], x[2 * n + 1] };
+
+            return half_.execute(z, z + M)
+                .and_then([this, z, M]() -> std::expected<void, std::string>
+                {
+                    const T r0 = z[0].real();
+                    const T i0 = z[0].imag();
+                    z[0] = { r0 + i0, 0 };
+                    z[M] = { r0 - i0, 0 };
+
+                    // Splitting Z[k] and Z[M - k] into the even E and the odd O spectra:
+                    // X[k] = E + w^k * O, X[M - k] = conj(E - w^k * O)
+                    for (size_t k = 1; k <= M / 2; ++k)
+                    {
+                        const auto a = z[k];
+                        const auto b = std::conj(z[M - k]);
+                        const std::complex<T> e = (a + b) * T{0.5};
+                        const std::complex<T> d = (a - b) * T{0.5};
+                        const std::complex<T> o { d.imag(), -d.real() }; // -i * d
+                        const auto& w = twiddles_[k];
+                        const std::complex<T> t
+                        {
+                            o.real() * w.real() - o.imag() * w.imag(),
+                            o.real() * w.imag() + o.imag() * w.real()
+                        };
+                        z[k]     = e + t;
+                        z[M - k] = std::conj(e - t);
+                    }
+                    return {};
+                });
+        }
+
+        /**
+         * @brief Inverse plan: transforms N/2 + 1 complex bins of a Hermitian spectrum into N reals, scaled by 1/N.
+         *
+         * @param begin The half-spectrum begin iterator.
+         * @param end The half-spectrum end iterator.
+         * @param out The begin iterator of the N reals; also serves as the work area, no scratch is allocated.
+         * @return std::expected<void, std::string>
+         * - Nothing on success;
+         * - Error string on failure.
+         */
+        template <fft_compatible_iterator It, std::contiguous_iterator Out>
+            requires std::same_as<std::iter_value_t<It>, std::complex<T>> && std::same_as<std::iter_value_t<Out>, T>
+        std::expected<void, std::string> execute(It begin, It end, Out out) const
+        {
+            if (half_.dir() != direction::inverse)
+                return std::unexpected("The plan is not of the inverse direction");
+            if (static_cast<size_t>(std::distance(begin, end)) != size_ / 2 + 1)
+                return std::unexpected(std::format("The half-spectrum size does not match the plan size={}/2+1", size_));
+
+            const size_t     M = size_ / 2;
+            std::complex<T>* z = reinterpret_cast<std::complex<T>*>(std::to_address(out)); // z[n] = x[2n] + i*x[2n + 1]
+
+            // Merging X[k] and X[M - k] back into Z[k] = E + i*O, where
+            // 2E = X[k] + conj(X[M - k]), 2O = (X[k] - conj(X[M - k])) * conj(w^k), the 2 goes to the final scaling
+            const T x0 = begin[0].real();
+            const T xm = begin[M].real();
+            z[0] = { x0 + xm, x0 - xm };
+            for (size_t k = 1; k <= M / 2; ++k)
+            {
+                const std::complex<T> a = begin[k];
+                const std::complex<T> b = std::conj(begin[M - k]);
+                const std::complex<T> e = a + b;
+                const std::complex<T> d = a - b;
+                const auto& w = twiddles_[k];
+                const std::complex<T> o
+                {
+                    d.real() * w.real() + d.imag() * w.imag(),
+                    d.imag() * w.real() - d.real() * w.imag()
+                };
+                const std::complex<T> io { -o.imag(), o.real() }; // i * O
+                z[k]     = e + io;
+                z[M - k] = std::conj(e) - std::conj(io); // conj(E) + i*conj(O)
+            }
+
+            return half_.execute(z, z + M)
+                .and_then([z, M]() -> std::expected<void, std::string>
+                {
+                    const T scale = T{1} / (2 * M);
+                    for (size_t n = 0; n < M; ++n)
+                        z[n] *= scale;
+                    return {};
+                });
+        }
+
+        size_t size() const noexcept { return size_; }
+        direction dir() const noexcept { return half_.dir(); }
+
+    private:
+        explicit real_plan(plan<T>&& half)
+            : half_(std::move(half)) {}
+
+        plan<T>                         half_;
+        size_t                          size_ = 0;
+        std::vector<std::complex<T>>    twiddles_;
+    };
+
+    /**
+     * @brief Performs FFT of the real sequence with the given plan.
+     *
+     * @param p A forward plan of the sequence size.
+     * @param begin The real sequence begin iterator.
+     * @param end The real sequence end iterator.
+     * @param out The begin iterator of the N/2 + 1 output bins.
+     * @return std::expected<void, std::string>
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <rfft_compatible_iterator It, std::contiguous_iterator Out>
+    std::expected<void, std::string> rfft(const real_plan<std::iter_value_t<It>>& p, It begin, It end, Out out)
+    {
+        return p.execute(begin, end, out);
+    }
+
+    /**
+     * @brief Performs IFFT of the Hermitian half-spectrum into the real sequence with the given plan.
+     *
+     * @param p An inverse plan of the real sequence size.
+     * @param begin The half-spectrum begin iterator.
+     * @param end The half-spectrum end iterator.
+     * @param out The begin iterator of the N output reals.
+     * @return std::expected<void, std::string>
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <fft_compatible_iterator It, std::contiguous_iterator Out>
+    std::expected<void, std::string> irfft(const real_plan<typename std::iter_value_t<It>::value_type>& p, It begin, It end, Out out)
+    {
+        return p.execute(begin, end, out);
+    }
+
+    /**
+     * @brief Performs FFT of the real sequence.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     *
+     * @param begin The real sequence begin iterator, N reals.
+     * @param end The real sequence end iterator.
+     * @param out The begin iterator of the N/2 + 1 output bins.
+     * @return std::expected<void, std::string>
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <rfft_compatible_iterator It, std::contiguous_iterator Out>
+    std::expected<void, std::string> rfft(It begin, It end, Out out)
+    {
+        using floating = std::iter_value_t<It>;
+        return detail::cached<real_plan<floating>>(std::distance(begin, end), direction::forward)
+            .and_then([begin, end, out](const real_plan<floating>* p)
+            {
+                return rfft(*p, begin, end, out);
+            });
+    }
+
+    /**
+     * @brief Performs IFFT of the Hermitian half-spectrum into the real sequence.
+     * The plan of the sequence size is created on the first use and kept for the calling thread.
+     *
+     * @param begin The half-spectrum begin iterator, N/2 + 1 bins.
+     * @param end The half-spectrum end iterator.
+     * @param out The begin iterator of the N output reals.
+     * @return std::expected<void, std::string>
+     * - Nothing on success;
+     * - Error string on failure.
+     */
+    template <fft_compatible_iterator It, std::contiguous_iterator Out>
+    std::expected<void, std::string> irfft(It begin, It end, Out out)
+    {
+        using floating = typename std::iter_value_t<It>::value_type;
+        const size_t bins = std::distance(begin, end);
+        if (bins < 2)
+            return std::unexpected("The half-spectrum must hold at least 2 bins");
+
+        return detail::cached<real_plan<floating>>(2 * (bins - 1), direction::inverse)
+            .and_then([begin, end, out](const real_plan<floating>* p)
+            {
+                return irfft(*p, begin, end, out);
+            });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string_view>
+
+// The vector kernels rely on the GCC/Clang function-level target selection,
+// so that a single build carries every instruction set and picks one at runtime.
+#if !defined(SDR_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define SDR_SIMD_X86 1
+#else
+    #define SDR_SIMD_X86 0
+#endif
+
+namespace simd
+{
+    /**
+     * Instruction sets the vector kernels are built for
+     */
+    enum class isa
+    {
+        scalar,
+        avx2,   // AVX2 + FMA
+        avx512  // AVX-512F
+    };
+
+    /**
+     * @brief Checks whether the CPU (and the OS) can run the kernels of the instruction set.
+     */
+    inline bool supported(isa set) noexcept
+    {
+        switch (set)
+        {
+        case isa::scalar:
+            return true;
+#if SDR_SIMD_X86
+        case isa::avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case isa::avx512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief The widest instruction set supported by the CPU, detected once.
+     */
+    inline isa detect() noexcept
+    {
+        static const isa best = supported(isa::avx512) ? isa::avx512
+                              : supported(isa::avx2)   ? isa::avx2
+                              :                          isa::scalar;
+        return best;
+    }
+
+    inline std::string_view name(isa set) noexcept
+    {
+        switch (set)
+        {
+        case isa::avx2:   return "avx2";
+        case isa::avx512: return "avx512";
+        default:          return "scalar";
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <complex>
+#include <concepts>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * An allocator of memory aligned to Align bytes, e.g. to a cache line or a vector register
+     */
+    template <typename T, size_t Align = 64>
+    struct aligned_allocator
+    {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = aligned_allocator<U, Align>;
+        };
+
+        aligned_allocator() noexcept = default;
+
+        template <typename U>
+        aligned_allocator(const aligned_allocator<U, Align>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Align}));
+        }
+
+        void deallocate(T* p, size_t) noexcept
+        {
+            ::operator delete(p, std::align_val_t{Align});
+        }
+
+        template <typename U>
+        bool operator==(const aligned_allocator<U, Align>&) const noexcept { return true; }
+    };
+
+    /**
+     * Complex samples in the split (structure-of-arrays) layout: the real and the imaginary parts
+     * live in separate arrays aligned to 64 bytes. Every lane of a vector register then carries
+     * the same component, which lets the vector kernels run at full width with no shuffles.
+     * Conversions from/to the interleaved std::complex layout are meant for the API edges.
+     */
+    template <std::floating_point T>
+    struct split_buffer
+    {
+        using array = std::vector<T, aligned_allocator<T>>;
+
+        split_buffer() = default;
+
+        explicit split_buffer(size_t size)
+            : re_(size, 0)
+            , im_(size, 0) {}
+
+        explicit split_buffer(std::span<const std::complex<T>> in)
+            : split_buffer(in.size())
+        {
+            from_interleaved(in);
+        }
+
+        /**
+         * @brief Replaces the content with the interleaved samples, resizing the buffer to fit them.
+         */
+        void from_interleaved(std::span<const std::complex<T>> in)
+        {
+            resize(in.size());
+            for (size_t i = 0; i < in.size(); ++i)
+            {
+                re_[i] = in[i].real();
+                im_[i] = in[i].imag();
+            }
+        }
+
+        /**
+         * @brief Writes the samples in the interleaved layout.
+         * @param out The destination, at least size() samples.
+         */
+        void to_interleaved(std::span<std::complex<T>> out) const
+        {
+            for (size_t i = 0; i < re_.size(); ++i)
+                out[i] = { re_[i], im_[i] };
+        }
+
+        std::vector<std::complex<T>> to_interleaved() const
+        {
+            std::vector<std::complex<T>> out(re_.size());
+            to_interleaved(out);
+            return out;
+        }
+
+        std::complex<T> operator[](size_t pos) const
+        {
+            return { re_[pos], im_[pos] };
+        }
+
+        void set(size_t pos, std::complex<T> val)
+        {
+            re_[pos] = val.real();
+            im_[pos] = val.imag();
+        }
+
+        void resize(size_t size)
+        {
+            re_.resize(size);
+            im_.resize(size);
+        }
+
+        size_t size() const
+        {
+            return re_.size();
+        }
+
+        std::span<T> real() { return re_; }
+        std::span<T> imag() { return im_; }
+        std::span<const T> real() const { return re_; }
+        std::span<const T> imag() const { return im_; }
+
+    private:
+        array re_;
+        array im_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ofdm
+{
+    enum class subcarrier : uint8_t
+    {
+        null,   // a guard band
+        dc,     // the zero frequency, left empty for the DC offset of the receiver
+        data,
+        pilot
+    };
+
+    /**
+     * The allocation of the subcarriers of a symbol: the data, the pilots, the guard bands and the DC.
+     * Precomputed once into the tables of the FFT bins of every kind, so mapping a symbol and extracting it back
+     * are straight scatter and gather loops without a branch per subcarrier.
+     */
+    class subcarrier_map
+    {
+    public:
+        /**
+         * @brief Creates the map.
+         *
+         * @param allocation The kinds of the subcarriers from the lowest frequency -N/2 to the highest one,
+         * the DC being at N/2. The data and the pilots keep this order.
+         * @param pilots The values of the pilot subcarriers.
+         * @return std::expected<subcarrier_map, std::string>
+         * - The map on success;
+         * - Error string on failure, e.g. the number of the pilot values does not match the pilot subcarriers.
+         */
+        static std::expected<subcarrier_map, std::string> create(std::span<const subcarrier> allocation, std::span<const std::complex<double>> pilots)
+        {
+            const size_t N = allocation.size();
+            if (N == 0)
+                return std::unexpected("The allocation is empty");
+
+            subcarrier_map m;
+            m.size_ = N;
+            m.pilot_values_.assign(pilots.begin(), pilots.end());
+            for (size_t i = 0; i < N; ++i)
+            {
+                const auto bin = static_cast<uint32_t>((i + N - N / 2) % N); // the centred order to the FFT order
+                switch (allocation[i])
+                {
+                case subcarrier::dc:
+                    if (bin != 0)
+                        return std::unexpected(std::format("The DC subcarrier is at {} instead of {}", i, N / 2));
+                    [[fallthrough]];
+                case subcarrier::null:
+                    m.null_.push_back(bin);
+                    break;
+                case subcarrier::data:
+                    m.data_.push_back(bin);
+                    break;
+                case subcarrier::pilot:
+                    m.pilots_.push_back(bin);
+                    break;
+                }
+            }
+            if (m.pilots_.size() != pilots.size())
+                return std::unexpected(std::format("The {} pilot values do not match the {} pilot subcarriers", pilots.size(), m.pilots_.size()));
+            return m;
+        }
+
+        /**
+         * @brief The 802.11a allocation of the 64 subcarriers 312.5 kHz apart: 48 data, the 4 pilots at -21, -7, 7
+         * and 21 being 1, 1, 1 and -1, the DC and the guard bands below -26 and above 26.
+         */
+        static subcarrier_map ieee80211a()
+        {
+            std::vector<subcarrier> allocation(64, subcarrier::null);
+            for (int k = -26; k <= 26; ++k)
+                allocation[k + 32] = subcarrier::data;
+            for (int k: { -21, -7, 7, 21 })
+                allocation[k + 32] = subcarrier::pilot;
+            allocation[32] = subcarrier::dc;
+            constexpr std::complex<double> pilots[] = { 1, 1, 1, -1 };
+            return create(allocation, pilots).value();
+        }
+
+        /**
+         * @brief Lays the data and the pilots out on the FFT bins of a symbol, zeroing the guard bands and the DC.
+         *
+         * @param data The data subcarriers, data_size() of them.
+         * @param symbol The symbol in the FFT order, size() bins.
+         * @param polarity The sign of the pilots of the symbol, e.g. of the 802.11a pilot scrambling sequence.
+         * @return std::expected<void, std::string>
+         * - Nothing on success;
+         * - Error string on failure, e.g. the sizes do not match the map.
+         */
+        template <std::floating_point T>
+        std::expected<void, std::string> map(std::span<const std::complex<T>> data, std::span<std::complex<T>> symbol, T polarity = 1) const
+        {
+            if (data.size() != data_.size() || symbol.size() != size_)
+                return std::unexpected(std::format("The {} data and {} bins do not fit the map of {} data and {} bins", data.size(), symbol.size(), data_.size(), size_));
+
+            for (size_t i = 0; i < data_.size(); ++i)
+                symbol[data_[i]] = data[i];
+            for (size_t i = 0; i < pilots_.size(); ++i)
+                symbol[pilots_[i]] = std::complex<T>(pilot_values_[i]) * polarity;
+            for (const auto bin: null_)
+                symbol[bin] = {};
+            return {};
+        }
+
+        /**
+         * @brief Gathers the data subcarriers of a symbol.
+         *
+         * @param symbol The symbol in the FFT order, size() bins.
+         * @param data The data subcarriers, data_size() of them.
+         */
+        template <std::floating_point T>
+        std::expected<void, std::string> extract(std::span<const std::complex<T>> symbol, std::span<std::complex<T>> data) const
+        {
+            return gather(symbol, data, data_);
+        }
+
+        /**
+         * @brief Gathers the pilot subcarriers of a symbol, e.g. for the channel estimation.
+         *
+         * @param symbol The symbol in the FFT order, size() bins.
+         * @param pilots The pilot subcarriers, pilot_size() of them.
+         */
+        template <std::floating_point T>
+        std::expected<void, std::string> extract_pilots(std::span<const std::complex<T>> symbol, std::span<std::complex<T>> pilots) const
+        {
+            return gather(symbol, pilots, pilots_);
+        }
+
+        size_t size() const noexcept { return size_; }
+        size_t data_size() const noexcept { return data_.size(); }
+        size_t pilot_size() const noexcept { return pilots_.size(); }
+
+        // The FFT bins of the data and of the pilots, in the order of the frequency
+        std::span<const uint32_t> data_bins() const noexcept { return data_; }
+        std::span<const uint32_t> pilot_bins() const noexcept { return pilots_; }
+        std::span<const std::complex<double>> pilot_values() const noexcept { return pilot_values_; }
+
+    private:
+        subcarrier_map() = default;
+
+        template <std::floating_point T>
+        std::expected<void, std::string> gather(std::span<const std::complex<T>> symbol, std::span<std::complex<T>> out, const std::vector<uint32_t>& bins) const
+        {
+            if (out.size() != bins.size() || symbol.size() != size_)
+                return std::unexpected(std::format("The {} subcarriers and {} bins do not fit the map of {} subcarriers and {} bins", out.size(), symbol.size(), bins.size(), size_));
+
+            for (size_t i = 0; i < bins.size(); ++i)
+                out[i] = symbol[bins[i]];
+            return {};
+        }
+
+        size_t                              size_ = 0;
+        std::vector<uint32_t>               data_;
+        std::vector<uint32_t>               pilots_;
+        std::vector<uint32_t>               null_;  // the guard bands and the DC
+        std::vector<std::complex<double>>   pilot_values_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ofdm
+{
+    /**
+     * A symbol found in the stream
+     */
+    template <std::floating_point T>
+    struct detection
+    {
+        uint64_t    index;  // the stream position of the first of the two repeated parts
+        T           metric; // the timing metric at the index, in [0, 1], 1 for a noiseless repetition
+        T           cfo;    // the fractional carrier frequency offset in cycles per sample, within +-1 / (2 * lag)
+    };
+
+    /**
+     * The streaming Schmidl-Cox synchronizer: finds the symbols made of two repeated parts `lag` samples apart,
+     * the preamble of two identical halves or, with the lag of the symbol size and the window of the cyclic prefix,
+     * any symbol against its prefix. Per sample it slides the correlation P of the `window` latest samples with the
+     * ones `lag` earlier and their energy R by a sample in O(1): the newest products and energies enter the running sums,
+     * the ones `window` samples old leave them, both recomputed from the history ring instead of being stored.
+     * R being the mean energy of both windows, the timing metric |P|^2 / R^2 stays within [0, 1], also on the edge of
+     * a burst followed by the silence. A detection is the peak of a run of the metric above the threshold, its CFO
+     * being the phase of P over the lag. The sums run in double and are summed anew from the ring every few thousand
+     * samples, so the rounding of the running updates never piles up, e.g. into a false metric of the silence after a burst.
+     */
+    template <std::floating_point T>
+    class synchronizer
+    {
+    public:
+        /**
+         * @brief Creates the synchronizer.
+         *
+         * @param lag The distance of the repeated parts, e.g. the half of the Schmidl-Cox preamble.
+         * @param window The length of the correlation, e.g. the half of the preamble again or the cyclic prefix.
+         * @param threshold The timing metric of a detection, in (0, 1].
+         * @return std::expected<synchronizer, std::string>
+         * - The synchronizer on success;
+         * - Error string on failure.
+         */
+        static std::expected<synchronizer, std::string> create(size_t lag, size_t window, T threshold = T{0.5})
+        {
+            if (lag == 0 || window == 0)
+                return std::unexpected(std::format("The lag={} and the window={} must be positive", lag, window));
+            if (!(threshold > 0 && threshold <= 1))
+                return std::unexpected(std::format("The threshold={} is out of (0, 1]", threshold));
+            return synchronizer(lag, window, threshold);
+        }
+
+        /**
+         * @brief Consumes the next samples of the stream, reporting every symbol found.
+         *
+         * @param in The samples.
+         * @param fn The callable of the detection<T>, invoked once the metric drops below the threshold past the peak.
+         */
+        template <typename Fn>
+        void process(std::span<const std::complex<T>> in, Fn&& fn)
+        {
+            const size_t mask = history_.size() - 1;
+            for (const auto& x: in)
+            {
+                const uint64_t n = count_++;
+                history_[n & mask] = x;
+                // The newest pair and energy in, the ones `window` samples old out
+                const std::complex<T> late = history_[(n - window_) & mask];
+                const std::complex<T> early = history_[(n - lag_) & mask];
+                const std::complex<T> earliest = history_[(n - window_ - lag_) & mask];
+                p_ += conj_mul(early, x) - conj_mul(earliest, late);
+                r_ += (energy(x) - energy(late) + energy(early) - energy(earliest)) / 2;
+                if (--refresh_ == 0)
+                    resum(n);
+
+                metric_ = n + 1 >= lag_ + window_ && r_ > 0 ? static_cast<T>(std::norm(p_) / (r_ * r_)) : T{0};
+                if (metric_ >= threshold_)
+                {
+                    if (!armed_ || metric_ > peak_.metric)
+                    {
+                        peak_ = { n + 1 - lag_ - window_, metric_, cfo() };
+                        armed_ = true;
+                    }
+                }
+                else if (armed_)
+                {
+                    armed_ = false;
+                    fn(peak_);
+                }
+            }
+        }
+
+        // The timing metric at the latest sample
+        T metric() const noexcept { return metric_; }
+
+        // The CFO estimate at the latest sample, in cycles per sample
+        T cfo() const noexcept { return static_cast<T>(std::arg(p_) / (2 * std::numbers::pi * lag_)); }
+
+        // The number of the samples consumed
+        uint64_t position() const noexcept { return count_; }
+
+    private:
+        synchronizer(size_t lag, size_t window, T threshold)
+            : history_(std::bit_ceil(lag + window + 1))
+            , lag_(lag)
+            , window_(window)
+            , threshold_(threshold)
+            , refresh_(std::max<size_t>(window, 4096)) {}
+
+        // conj(a) * b in double, spelled out to skip the NaN recovery of the complex multiplication
+        static std::complex<double> conj_mul(std::complex<T> a, std::complex<T> b) noexcept
+        {
+            const double ar = a.real(), ai = a.imag(), br = b.real(), bi = b.imag();
+            return { ar * br + ai * bi, ar * bi - ai * br };
+        }
+
+        static double energy(std::complex<T> a) noexcept
+        {
+            const double ar = a.real(), ai = a.imag();
+            return ar * ar + ai * ai;
+        }
+
+        // Sums the window ending at the sample n exactly, in O(window) once per refresh period
+        void resum(uint64_t n) noexcept
+        {
+            const size_t mask = history_.size() - 1;
+            p_ = {};
+            r_ = 0;
+            for (uint64_t m = n - window_ + 1; m != n + 1; ++m)
+            {
+                p_ += conj_mul(history_[(m - lag_) & mask], history_[m & mask]);
+                r_ += (energy(history_[m & mask]) + energy(history_[(m - lag_) & mask])) / 2;
+            }
+            refresh_ = std::max<size_t>(window_, 4096);
+        }
+
+        std::vector<std::complex<T>>    history_;   // the ring of the latest lag + window + 1 samples at least, zeros before the stream
+        size_t                          lag_;
+        size_t                          window_;
+        T                               threshold_;
+        size_t                          refresh_;   // the samples left to the exact sums
+        uint64_t                        count_ = 0;
+        std::complex<double>            p_;
+        double                          r_ = 0;
+        T                               metric_ = 0;
+        bool                            armed_ = false;
+        detection<T>                    peak_{};
+    };
+}
\ No newline at end of file
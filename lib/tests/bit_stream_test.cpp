@@ -0,0 +1,41 @@
+#include "bit_stream.hpp"
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using utils::bit_reader;
+using utils::bit_writer;
+
+TEST(BitStream, ReadsMostSignificantBitsFirstAndPadsWithZeros)
+{
+    const std::vector<uint8_t> in{0b10110011, 0b01011100};
+    bit_reader reader(in);
+    EXPECT_EQ(reader.read(3), 0b101u);
+    EXPECT_EQ(reader.read(6), 0b100110u); // across the byte boundary
+    EXPECT_EQ(reader.read(7), 0b1011100u);
+    EXPECT_EQ(reader.read(10), 0u);       // past the end
+}
+
+TEST(BitStream, WritesWhatIsReadAtAnyWidth)
+{
+    std::mt19937 gen(3);
+    std::vector<uint8_t> in(1001);
+    for (auto& b: in)
+        b = static_cast<uint8_t>(gen());
+
+    for (size_t bits = 1; bits <= 32; ++bits)
+    {
+        const size_t chunks = in.size() * 8 / bits;
+        std::vector<uint8_t> out(chunks * bits / 8 + 1, 0xEE);
+        bit_reader reader(in);
+        bit_writer writer(out.data());
+        for (size_t n = 0; n < chunks; ++n)
+            writer.write(reader.read(bits), bits);
+
+        EXPECT_EQ(writer.flush(), out.data() + chunks * bits / 8) << bits;
+        EXPECT_TRUE(std::equal(out.begin(), out.end() - 1, in.begin())) << bits;
+        EXPECT_EQ(out.back(), 0xEE) << bits; // the bits short of a byte are dropped
+    }
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "channel.hpp"
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::ElementsAre;
+
+TEST(Channel, PhiloxMatchesTheKnownAnswers)
+{
+    // The known answer vectors of Random123
+    uint32_t out[4];
+    sim::philox4x32({ 0, 0, 0, 0 }, { 0, 0 }, out, 1);
+    EXPECT_THAT(out, ElementsAre(0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u));
+    sim::philox4x32({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, out, 1);
+    EXPECT_THAT(out, ElementsAre(0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu));
+    sim::philox4x32({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, out, 1);
+    EXPECT_THAT(out, ElementsAre(0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u));
+
+    // A block of a run is the block of its counter alone
+    std::vector<uint32_t> run(4 * 37);
+    sim::philox4x32({ 5, 0, 7, 0 }, { 1, 2 }, run.data(), 37);
+    sim::philox4x32({ 5 + 36, 0, 7, 0 }, { 1, 2 }, out, 1);
+    EXPECT_TRUE(std::equal(out, out + 4, run.end() - 4));
+}
+
+TEST(Channel, NoiseHasTheVarianceAndStreamsAreReproducible)
+{
+    std::vector<std::complex<double>> a(100000), b(100000);
+    sim::philox_stream(42, 3).gaussian(std::span(a), 0.5);
+    sim::philox_stream(42, 3).gaussian(std::span(b), 0.5);
+    EXPECT_EQ(a, b);
+
+    std::complex<double> mean = 0;
+    double power = 0;
+    for (const auto& v: a)
+    {
+        mean += v;
+        power += std::norm(v);
+    }
+    EXPECT_NEAR(std::abs(mean / double(a.size())), 0, 0.01);
+    EXPECT_NEAR(power / a.size(), 0.5, 0.01);
+
+    sim::philox_stream(42, 4).gaussian(std::span(b), 0.5);
+    EXPECT_NE(a, b);
+}
+
+TEST(Channel, AppliesTheMultipathAndTheFrequencyOffset)
+{
+    const std::vector<std::complex<double>> in{ 1, 2, 3, 4 };
+    std::vector<std::complex<double>> out(in.size());
+    sim::philox_stream random(0, 0);
+
+    auto multipath = sim::channel<double>::create({ .taps = { 1, 0.5 } });
+    ASSERT_TRUE(multipath.has_value());
+    ASSERT_TRUE(multipath->apply(in, out, random).has_value());
+    EXPECT_THAT(out, ElementsAre(1, 2.5, 4, 5.5));
+
+    auto offset = sim::channel<double>::create({ .cfo = 0.25 });
+    ASSERT_TRUE(offset.has_value());
+    ASSERT_TRUE(offset->apply(in, out, random).has_value());
+    const std::complex<double> expected[] = { 1, { 0, 2 }, -3, { 0, -4 } };
+    for (size_t n = 0; n < in.size(); ++n)
+        EXPECT_NEAR(std::abs(out[n] - expected[n]), 0, 1e-12) << n;
+
+    EXPECT_FALSE(sim::channel<double>::create({ .taps = {} }).has_value());
+    EXPECT_FALSE(sim::channel<double>::create({ .noise_variance = -1 }).has_value());
+}
+
+TEST(Channel, SweepMatchesTheTheoreticalBerAndIsReproducible)
+{
+    sim::sweep_config config{ .snr_db = { 4, 8 }, .frames = 200, .channel = { .taps = { 0.8, { 0.3, 0.2 } } }, .seed = 24 };
+    const auto points = sim::ber_sweep<modulation::eQPSK>(config);
+    ASSERT_TRUE(points.has_value());
+    ASSERT_EQ(points->size(), 2u);
+
+    // The zero forcing lets the noise of the faded subcarriers through: check the flat channel against the theory
+    config.channel.taps = { 1 };
+    const auto flat = sim::ber_sweep<modulation::eQPSK>(config);
+    ASSERT_TRUE(flat.has_value());
+    for (const auto& p: *flat)
+    {
+        const double theory = 0.5 * std::erfc(std::sqrt(std::pow(10, p.snr_db / 10) / 2)); // Q(sqrt(Es/N0))
+        EXPECT_EQ(p.bits, 200u * 8 * 64 * 2);
+        EXPECT_NEAR(p.ber(), theory, 0.1 * theory) << p.snr_db;
+    }
+    EXPECT_GT((*points)[0].ber(), (*flat)[0].ber());
+
+    const auto again = sim::ber_sweep<modulation::eQPSK>(config);
+    ASSERT_TRUE(again.has_value());
+    for (size_t p = 0; p < flat->size(); ++p)
+        EXPECT_EQ((*again)[p].errors, (*flat)[p].errors);
+
+    config.size = 3;
+    EXPECT_FALSE(sim::ber_sweep<modulation::eQPSK>(config).has_value());
+}
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include "fft.hpp"
+#include "rfft.hpp"
+#include "fft_q15.hpp"
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <vector>
 #include <complex>
 #include <gtest/gtest.h>
@@ -64,9 +70,648 @@ TEST(FFTTest, FftIfftForFloat)
     }), ref));
 }
 
-TEST(FFTTest, SizeNonMultipleOf2Fails)
+TEST(FFTTest, SizeNonMultipleOf2Succeeds)
 {
+    std::vector<std::complex<double>> ref{0,1,2};
     std::vector<std::complex<double>> seq{0,1,2};
 
-    ASSERT_FALSE((fft::fft2(seq.begin(), seq.end()).has_value()));
+    ASSERT_TRUE((fft::fft2(seq.begin(), seq.end()).has_value()));
+    ASSERT_TRUE((fft::ifft2(seq.begin(), seq.end()).has_value()));
+
+    EXPECT_THAT(seq, Pointwise(Truly([](const auto& pair)
+    {
+        const auto& [a, b] = pair;
+        return std::abs(a - b) < 1e-9;
+    }), ref));
+}
+
+namespace
+{
+    template <typename T>
+    std::vector<std::complex<T>> naive_dft(const std::vector<std::complex<T>>& in, bool inverse = false)
+    {
+        const size_t N = in.size();
+        std::vector<std::complex<T>> out(N);
+        for (size_t k = 0; k < N; ++k)
+        {
+            std::complex<long double> acc = 0;
+            for (size_t n = 0; n < N; ++n)
+            {
+                const long double theta = (inverse ? 2.0L : -2.0L) * std::numbers::pi_v<long double> * ((n * k) % N) / N;
+                acc += std::complex<long double>(in[n]) * std::polar(1.0L, theta);
+            }
+            out[k] = std::complex<T>(acc);
+        }
+        return out;
+    }
+
+    template <typename T>
+    std::vector<std::complex<T>> test_signal(size_t size)
+    {
+        std::vector<std::complex<T>> seq(size);
+        for (size_t i = 0; i < size; ++i)
+            seq[i] = { static_cast<T>(std::sin(0.37 * i) + 0.1 * (i % 7)), static_cast<T>(std::cos(1.3 * i) - 0.2 * (i % 3)) };
+        return seq;
+    }
+
+    template <typename T>
+    T max_error(const std::vector<std::complex<T>>& a, const std::vector<std::complex<T>>& b)
+    {
+        T err = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            err = std::max(err, std::abs(a[i] - b[i]));
+        return err;
+    }
+}
+
+TEST(FFTTest, PlanMatchesNaiveDft)
+{
+    auto p = fft::plan<double>::create(64);
+    ASSERT_TRUE(p.has_value());
+
+    auto seq = test_signal<double>(64);
+    const auto ref = naive_dft(seq);
+
+    // The same plan serves any number of transforms
+    for (int run = 0; run < 3; ++run)
+    {
+        auto cur = seq;
+        ASSERT_TRUE(fft::fft2(*p, cur.begin(), cur.end()).has_value());
+        EXPECT_LT(max_error(cur, ref), 1e-11);
+    }
+}
+
+TEST(FFTTest, PlanKeepsPrecisionForLargeSizes)
+{
+    const size_t size = 1 << 16;
+    auto fwd = fft::plan<double>::create(size);
+    auto inv = fft::plan<double>::create(size, fft::direction::inverse);
+    ASSERT_TRUE(fwd.has_value() && inv.has_value());
+
+    const auto ref = test_signal<double>(size);
+    auto seq = ref;
+    ASSERT_TRUE(fft::fft2(*fwd, seq.begin(), seq.end()).has_value());
+    ASSERT_TRUE(fft::ifft2(*inv, seq.begin(), seq.end()).has_value());
+
+    EXPECT_LT(max_error(seq, ref), 1e-12);
+}
+
+TEST(FFTTest, PlanRejectsMismatchingSequence)
+{
+    auto p = fft::plan<double>::create(8);
+    ASSERT_TRUE(p.has_value());
+
+    std::vector<std::complex<double>> seq(16);
+    EXPECT_FALSE(p->execute(seq.begin(), seq.end()).has_value());
+    EXPECT_FALSE(fft::ifft2(*p, seq.begin(), seq.begin() + 8).has_value()); // forward plan for the inverse transform
+}
+
+
+namespace
+{
+    template <typename T>
+    void expect_isa_matches_scalar(simd::isa set, T tolerance)
+    {
+        if (!simd::supported(set))
+            GTEST_SKIP() << simd::name(set) << " is not supported by the CPU";
+
+        for (size_t size = 1; size <= 4096; size <<= 1)
+        {
+            for (auto dir: {fft::direction::forward, fft::direction::inverse})
+            {
+                SCOPED_TRACE(std::format("isa={} size={} inverse={}", simd::name(set), size, dir == fft::direction::inverse));
+
+                auto ref_plan = fft::plan<T>::create(size, dir, simd::isa::scalar);
+                auto vec_plan = fft::plan<T>::create(size, dir, set);
+                ASSERT_TRUE(ref_plan.has_value() && vec_plan.has_value());
+                EXPECT_EQ(vec_plan->isa(), set);
+
+                auto ref = test_signal<T>(size);
+                auto seq = ref;
+                ASSERT_TRUE(ref_plan->execute(ref.begin(), ref.end()).has_value());
+                ASSERT_TRUE(vec_plan->execute(seq.begin(), seq.end()).has_value());
+
+                EXPECT_LT(max_error(seq, ref), tolerance * std::max<size_t>(size, 1));
+            }
+        }
+    }
+}
+
+TEST(FFTTest, ScalarKernelsMatchNaiveDft)
+{
+    for (size_t size: {2, 4, 8, 32, 128})
+    {
+        auto p = fft::plan<double>::create(size, fft::direction::inverse, simd::isa::scalar);
+        ASSERT_TRUE(p.has_value());
+
+        auto seq = test_signal<double>(size);
+        const auto ref = naive_dft(seq, true);
+        ASSERT_TRUE(p->execute(seq.begin(), seq.end()).has_value());
+        EXPECT_LT(max_error(seq, ref), 1e-11);
+    }
+}
+
+TEST(FFTTest, Avx2KernelsMatchScalarForDouble)   { expect_isa_matches_scalar<double>(simd::isa::avx2, 1e-14); }
+TEST(FFTTest, Avx2KernelsMatchScalarForFloat)    { expect_isa_matches_scalar<float>(simd::isa::avx2, 1e-5f); }
+TEST(FFTTest, Avx512KernelsMatchScalarForDouble) { expect_isa_matches_scalar<double>(simd::isa::avx512, 1e-14); }
+TEST(FFTTest, Avx512KernelsMatchScalarForFloat)  { expect_isa_matches_scalar<float>(simd::isa::avx512, 1e-5f); }
+
+TEST(FFTTest, UnsupportedInstructionSetFails)
+{
+    for (auto set: {simd::isa::avx2, simd::isa::avx512})
+    {
+        if (!simd::supported(set))
+        {
+            EXPECT_FALSE(fft::plan<double>::create(8, fft::direction::forward, set).has_value());
+        }
+    }
+    EXPECT_TRUE(fft::plan<double>::create(8, fft::direction::forward, simd::isa::scalar).has_value());
+}
+
+TEST(FFTTest, BatchContiguousMatchesSingleTransforms)
+{
+    const size_t size = 64, count = 37;
+    auto batch = test_signal<double>(size * count);
+
+    auto ref = batch;
+    for (size_t k = 0; k < count; ++k)
+        ASSERT_TRUE(fft::fft2(ref.begin() + k * size, ref.begin() + (k + 1) * size).has_value());
+
+    ASSERT_TRUE(fft::fft2_batch(batch.begin(), batch.end(), count).has_value());
+    EXPECT_LT(max_error(batch, ref), 1e-12);
+}
+
+TEST(FFTTest, BatchInterleavedMatchesSingleTransforms)
+{
+    for (simd::isa set: {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+    {
+        if (!simd::supported(set))
+            continue;
+
+        const size_t size = 32, count = 13; // The count is not a multiple of any register width
+        SCOPED_TRACE(simd::name(set));
+
+        auto p = fft::plan<float>::create(size, fft::direction::forward, set);
+        ASSERT_TRUE(p.has_value());
+
+        auto batch = test_signal<float>(size * count);
+        auto ref = batch;
+        for (size_t k = 0; k < count; ++k)
+        {
+            std::vector<std::complex<float>> seq(size);
+            for (size_t n = 0; n < size; ++n)
+                seq[n] = ref[n * count + k];
+            ASSERT_TRUE(fft::fft2(seq.begin(), seq.end()).has_value());
+            for (size_t n = 0; n < size; ++n)
+                ref[n * count + k] = seq[n];
+        }
+
+        ASSERT_TRUE(fft::fft2_batch(*p, batch.begin(), batch.end(), fft::layout::interleaved).has_value());
+        EXPECT_LT(max_error(batch, ref), 1e-4f);
+    }
+}
+
+TEST(FFTTest, BatchTransformsForthAndBackAcrossThreads)
+{
+    const size_t size = 256, count = 512;
+    const auto ref = test_signal<double>(size * count);
+
+    for (auto order: {fft::layout::contiguous, fft::layout::interleaved})
+    {
+        auto batch = ref;
+        // A low threshold forces the split across threads even on a small batch
+        ASSERT_TRUE(fft::fft2_batch<1024>(batch.begin(), batch.end(), count, order).has_value());
+        ASSERT_TRUE(fft::ifft2_batch<1024>(batch.begin(), batch.end(), count, order).has_value());
+        EXPECT_LT(max_error(batch, ref), 1e-12);
+    }
+}
+
+TEST(FFTTest, BatchSkipsGapsBetweenSequences)
+{
+    const size_t size = 16, gap = 4, count = 5;
+    auto p = fft::plan<double>::create(size);
+    ASSERT_TRUE(p.has_value());
+
+    auto batch = test_signal<double>((size + gap) * count);
+    auto ref = batch;
+    for (size_t k = 0; k < count; ++k)
+        ASSERT_TRUE(fft::fft2(ref.begin() + k * (size + gap) + gap, ref.begin() + (k + 1) * (size + gap)).has_value());
+
+    ASSERT_TRUE(p->execute_batch(batch.begin() + gap, count, fft::layout::contiguous, size + gap).has_value());
+    EXPECT_LT(max_error(batch, ref), 1e-12);
+}
+
+TEST(FFTTest, BatchRejectsIncompleteSequences)
+{
+    std::vector<std::complex<double>> batch(100);
+    EXPECT_FALSE(fft::fft2_batch(batch.begin(), batch.end(), 3).has_value());
+    EXPECT_FALSE(fft::fft2_batch(batch.begin(), batch.end(), 0).has_value());
+}
+
+
+TEST(FFTTest, RealFftMatchesComplexFft)
+{
+    for (size_t size: {2, 4, 8, 12, 30, 64, 1024})
+    {
+        SCOPED_TRACE(size);
+        std::vector<double> reals(size);
+        for (size_t i = 0; i < size; ++i)
+            reals[i] = std::sin(0.3 * i) + 0.5 * std::cos(2.1 * i) + 0.25;
+
+        std::vector<std::complex<double>> ref(reals.begin(), reals.end());
+        ASSERT_TRUE(fft::fft2(ref.begin(), ref.end()).has_value());
+        ref.resize(size / 2 + 1);
+
+        std::vector<std::complex<double>> half(size / 2 + 1);
+        ASSERT_TRUE(fft::rfft(reals.begin(), reals.end(), half.begin()).has_value());
+        EXPECT_LT(max_error(half, ref), 1e-11);
+    }
+}
+
+TEST(FFTTest, RealFftForthAndBackForFloat)
+{
+    const size_t size = 256;
+    std::vector<float> reals(size);
+    for (size_t i = 0; i < size; ++i)
+        reals[i] = static_cast<float>(std::sin(0.05 * i) - 0.1 * (i % 5));
+
+    auto fwd = fft::real_plan<float>::create(size);
+    auto inv = fft::real_plan<float>::create(size, fft::direction::inverse);
+    ASSERT_TRUE(fwd.has_value() && inv.has_value());
+
+    std::vector<std::complex<float>> half(size / 2 + 1);
+    std::vector<float> back(size);
+    ASSERT_TRUE(fft::rfft(*fwd, reals.begin(), reals.end(), half.begin()).has_value());
+    ASSERT_TRUE(fft::irfft(*inv, half.begin(), half.end(), back.begin()).has_value());
+
+    for (size_t i = 0; i < size; ++i)
+        EXPECT_NEAR(back[i], reals[i], 1e-5f);
+}
+
+TEST(FFTTest, RealFftRejectsMismatchingSizes)
+{
+    std::vector<double> reals(7);
+    std::vector<std::complex<double>> half(8);
+    EXPECT_FALSE(fft::rfft(reals.begin(), reals.end(), half.begin()).has_value());
+
+    auto inv = fft::real_plan<double>::create(16, fft::direction::inverse);
+    ASSERT_TRUE(inv.has_value());
+    std::vector<double> out(16);
+    EXPECT_FALSE(fft::irfft(*inv, half.begin(), half.begin() + 8, out.begin()).has_value()); // 9 bins expected
+}
+
+
+TEST(FFTTest, MixedRadixSizesMatchNaiveDft)
+{
+    for (size_t size: {3, 5, 6, 12, 15, 20, 45, 96, 100, 1536})
+    {
+        for (auto dir: {fft::direction::forward, fft::direction::inverse})
+        {
+            SCOPED_TRACE(std::format("size={} inverse={}", size, dir == fft::direction::inverse));
+            auto p = fft::plan<double>::create(size, dir);
+            ASSERT_TRUE(p.has_value());
+            EXPECT_EQ(p->kind(), fft::plan<double>::algorithm::mixed_radix);
+
+            auto seq = test_signal<double>(size);
+            const auto ref = naive_dft(seq, dir == fft::direction::inverse);
+            ASSERT_TRUE(p->execute(seq.begin(), seq.end()).has_value());
+            EXPECT_LT(max_error(seq, ref), 1e-10 * size);
+        }
+    }
+}
+
+TEST(FFTTest, BluesteinSizesMatchNaiveDft)
+{
+    for (size_t size: {7, 11, 13, 14, 97, 1000 + 9})
+    {
+        for (auto dir: {fft::direction::forward, fft::direction::inverse})
+        {
+            SCOPED_TRACE(std::format("size={} inverse={}", size, dir == fft::direction::inverse));
+            auto p = fft::plan<double>::create(size, dir);
+            ASSERT_TRUE(p.has_value());
+            EXPECT_EQ(p->kind(), fft::plan<double>::algorithm::bluestein);
+
+            auto seq = test_signal<double>(size);
+            const auto ref = naive_dft(seq, dir == fft::direction::inverse);
+            ASSERT_TRUE(p->execute(seq.begin(), seq.end()).has_value());
+            EXPECT_LT(max_error(seq, ref), 1e-10 * size);
+        }
+    }
+}
+
+TEST(FFTTest, ArbitrarySizesForthAndBackForFloat)
+{
+    for (size_t size: {24, 75, 127})
+    {
+        SCOPED_TRACE(size);
+        const auto ref = test_signal<float>(size);
+        auto seq = ref;
+        ASSERT_TRUE(fft::fft2(seq.begin(), seq.end()).has_value());
+        ASSERT_TRUE(fft::ifft2(seq.begin(), seq.end()).has_value());
+        EXPECT_LT(max_error(seq, ref), 1e-4f);
+    }
+}
+
+TEST(FFTTest, ArbitrarySizesInBatches)
+{
+    const size_t size = 12, count = 9;
+    for (auto order: {fft::layout::contiguous, fft::layout::interleaved})
+    {
+        const auto ref = test_signal<double>(size * count);
+        auto batch = ref;
+        ASSERT_TRUE(fft::fft2_batch(batch.begin(), batch.end(), count, order).has_value());
+        ASSERT_TRUE(fft::ifft2_batch(batch.begin(), batch.end(), count, order).has_value());
+        EXPECT_LT(max_error(batch, ref), 1e-12);
+    }
+}
+
+TEST(FFTTest, SplitLayoutMatchesInterleavedForEveryKernel)
+{
+    for (auto set: {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+    {
+        if (!simd::supported(set))
+            continue;
+        for (size_t size: {2, 8, 64, 1024, 12, 31})
+        {
+            SCOPED_TRACE(std::format("{} {}", simd::name(set), size));
+            const auto p = fft::plan<float>::create(size, fft::direction::forward, set);
+            ASSERT_TRUE(p.has_value());
+
+            auto ref = test_signal<float>(size);
+            utils::split_buffer<float> split(ref);
+            ASSERT_TRUE(p->execute(ref.begin(), ref.end()).has_value());
+            ASSERT_TRUE(p->execute(split.real(), split.imag()).has_value());
+            EXPECT_LT(max_error(split.to_interleaved(), ref), 1e-4f);
+        }
+    }
+}
+
+TEST(FFTTest, SplitLayoutForthAndBack)
+{
+    const auto ref = test_signal<double>(256);
+    utils::split_buffer<double> seq(ref);
+    ASSERT_TRUE(fft::fft2(seq).has_value());
+    ASSERT_TRUE(fft::ifft2(seq).has_value());
+    EXPECT_LT(max_error(seq.to_interleaved(), ref), 1e-12);
+}
+
+TEST(FFTTest, StockhamMatchesNaiveDftOutOfPlace)
+{
+    for (auto set: {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+    {
+        if (!simd::supported(set))
+            continue;
+        for (size_t size: {1, 2, 4, 32, 256, 2048})
+        {
+            SCOPED_TRACE(std::format("{} {}", simd::name(set), size));
+            for (auto dir: {fft::direction::forward, fft::direction::inverse})
+            {
+                const auto p = fft::plan<double>::create(size, dir, set, fft::plan<double>::algorithm::stockham);
+                ASSERT_TRUE(p.has_value());
+
+                const auto src = test_signal<double>(size);
+                std::vector<std::complex<double>> dst(size);
+                ASSERT_TRUE(p->execute(src.begin(), src.end(), dst.begin()).has_value());
+                EXPECT_LT(max_error(dst, naive_dft(src, dir == fft::direction::inverse)), 1e-9);
+                EXPECT_EQ(src, test_signal<double>(size)); // The source is left intact
+
+                auto seq = src; // In place as well
+                ASSERT_TRUE(p->execute(seq.begin(), seq.end()).has_value());
+                EXPECT_EQ(seq, dst);
+            }
+        }
+    }
+}
+
+TEST(FFTTest, SelectedAlgorithmMustSuitTheSize)
+{
+    using algorithm = fft::plan<float>::algorithm;
+    EXPECT_FALSE(fft::plan<float>::create(12, fft::direction::forward, simd::isa::scalar, algorithm::stockham).has_value());
+    EXPECT_FALSE(fft::plan<float>::create(14, fft::direction::forward, simd::isa::scalar, algorithm::mixed_radix).has_value());
+
+    const auto p = fft::plan<float>::create(16, fft::direction::forward, simd::isa::scalar, algorithm::bluestein);
+    ASSERT_TRUE(p.has_value());
+    EXPECT_EQ(p->kind(), algorithm::bluestein);
+}
+
+template <typename T>
+class FFTCodeletTest : public ::testing::Test {};
+
+using Floatings = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(FFTCodeletTest, Floatings);
+
+TYPED_TEST(FFTCodeletTest, CodeletsMatchNaiveDft)
+{
+    using T = TypeParam;
+    const T eps = std::is_same_v<T, float> ? T{1e-4} : T{1e-11};
+    const auto check = [eps]<size_t N>()
+    {
+        SCOPED_TRACE(N);
+        const auto src = test_signal<T>(N);
+        auto seq = src;
+        fft::fft2<N>(seq.begin());
+        EXPECT_LT(max_error(seq, naive_dft(src)), eps);
+
+        auto inv = naive_dft(src, true);
+        for (auto& v: inv)
+            v /= T(N);
+        seq = src;
+        fft::ifft2<N>(seq.begin());
+        EXPECT_LT(max_error(seq, inv), eps);
+    };
+    [&]<size_t... S>(std::index_sequence<S...>) { (check.template operator()<size_t{2} << S>(), ...); }(std::make_index_sequence<8>{});
+}
+
+TEST(FFTTest, RuntimeSizeForwardsToCodelets)
+{
+    for (size_t size: {2, 8, 16, 32})
+    {
+        SCOPED_TRACE(size);
+        const auto src = test_signal<double>(size);
+        auto seq = src;
+        ASSERT_TRUE(fft::fft2(seq.begin(), seq.end()).has_value());
+        EXPECT_LT(max_error(seq, naive_dft(src)), 1e-11);
+        ASSERT_TRUE(fft::ifft2(seq.begin(), seq.end()).has_value());
+        EXPECT_LT(max_error(seq, src), 1e-12);
+    }
+}
+
+TEST(FFTTest, FourStepMatchesNaiveDft)
+{
+    using algorithm = fft::plan<double>::algorithm;
+    for (auto set: {simd::isa::scalar, simd::detect()})
+    {
+        for (size_t size: {4, 8, 32, 512, 2048})
+        {
+            SCOPED_TRACE(std::format("{} {}", simd::name(set), size));
+            for (auto dir: {fft::direction::forward, fft::direction::inverse})
+            {
+                const auto p = fft::plan<double>::create(size, dir, set, algorithm::four_step);
+                ASSERT_TRUE(p.has_value());
+
+                auto seq = test_signal<double>(size);
+                const auto ref = naive_dft(seq, dir == fft::direction::inverse);
+                ASSERT_TRUE(p->execute(seq.begin(), seq.end()).has_value());
+                EXPECT_LT(max_error(seq, ref), 1e-9);
+            }
+        }
+    }
+}
+
+TEST(FFTTest, LargeSizesRunFourStepOnMultipleCores)
+{
+    const size_t size = fft::plan<double>::four_step_size;
+    const auto p = fft::plan<double>::create(size);
+    const auto ref = fft::plan<double>::create(size, fft::direction::forward, simd::detect(), fft::plan<double>::algorithm::radix2);
+    ASSERT_TRUE(p.has_value() && ref.has_value());
+    EXPECT_EQ(p->kind() == fft::plan<double>::algorithm::four_step, parallel::concurrency() > 1);
+
+    auto a = test_signal<double>(size);
+    auto b = a;
+    ASSERT_TRUE(p->execute(a.begin(), a.end()).has_value());
+    ASSERT_TRUE(ref->execute(b.begin(), b.end()).has_value());
+    EXPECT_LT(max_error(a, b), 1e-9);
+}
+
+namespace
+{
+    // Delegates to the built-in plans and counts the calls
+    class counting_backend : public fft::builtin_backend<double>
+    {
+    public:
+        counting_backend() : fft::builtin_backend<double>(simd::isa::scalar) {}
+
+        std::string_view name() const noexcept override { return "counting"; }
+
+        std::expected<void, std::string> execute(std::complex<double>* x, size_t size, fft::direction dir,
+                                                 size_t parallel_threshold) const override
+        {
+            ++calls;
+            return fft::builtin_backend<double>::execute(x, size, dir, parallel_threshold);
+        }
+
+        mutable std::atomic<size_t> calls = 0;
+    };
+}
+
+TEST(FFTTest, RegistryRoutesToTheBackendOfTheWisdom)
+{
+    auto& registry = fft::registry<double>::instance();
+    const auto counting = std::make_shared<counting_backend>();
+    registry.add(counting);
+
+    const auto path = std::filesystem::temp_directory_path() / "sdrlib_fft_wisdom_test";
+    // Leaves the shared registry as it was for the other tests, whatever the outcome
+    struct cleanup
+    {
+        std::filesystem::path path;
+        ~cleanup()
+        {
+            fft::registry<double>::instance().remove("counting");
+            std::filesystem::remove(path);
+        }
+    } const guard{ path };
+    {
+        std::ofstream out(path);
+        out << "float 96 forward counting\ndouble 96 forward counting\n";
+    }
+    ASSERT_TRUE(registry.load_wisdom(path.string()).has_value());
+
+    const auto src = test_signal<double>(96);
+    auto seq = src;
+    ASSERT_TRUE(fft::fft2(seq.begin(), seq.end()).has_value());
+    EXPECT_EQ(counting->calls, 1u);
+    EXPECT_LT(max_error(seq, naive_dft(src)), 1e-11);
+
+    // The autotuned choices are saved next to the entries of the other precision
+    const auto& tuned = registry.select(24, fft::direction::inverse);
+    ASSERT_TRUE(registry.save_wisdom(path.string()).has_value());
+    std::ifstream in(path);
+    const std::string wisdom{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    EXPECT_THAT(wisdom, ::testing::HasSubstr("float 96 forward counting\n"));
+    EXPECT_THAT(wisdom, ::testing::HasSubstr("double 96 forward counting\n"));
+    EXPECT_THAT(wisdom, ::testing::HasSubstr(std::format("double 24 inverse {}\n", tuned.name())));
+
+    // The removal reaches the choices the thread has remembered
+    registry.remove("counting");
+    const size_t calls = counting->calls;
+    seq = src;
+    ASSERT_TRUE(fft::fft2(seq.begin(), seq.end()).has_value());
+    EXPECT_EQ(counting->calls, calls);
+    EXPECT_LT(max_error(seq, naive_dft(src)), 1e-11);
+}
+
+TEST(FFTTest, RegistryRejectsMalformedWisdom)
+{
+    const auto path = std::filesystem::temp_directory_path() / "sdrlib_fft_malformed_wisdom_test";
+    {
+        std::ofstream out(path);
+        out << "double 64 sideways fftw\n";
+    }
+    EXPECT_FALSE(fft::registry<double>::instance().load_wisdom(path.string()).has_value());
+    EXPECT_FALSE(fft::registry<double>::instance().load_wisdom((path / "missing").string()).has_value());
+    std::filesystem::remove(path);
+}
+
+TEST(FFTTest, FixedPointFftTracksTheBlockExponent)
+{
+    // The error power relative to the signal power in dB
+    const auto snr = [](const std::vector<fixed::iq16>& x, int exponent, const std::vector<std::complex<double>>& ref)
+    {
+        double signal = 0, noise = 0;
+        for (size_t n = 0; n < ref.size(); ++n)
+        {
+            signal += std::norm(ref[n]);
+            noise += std::norm(fixed::to_complex<double>(x[n], exponent) - ref[n]);
+        }
+        return 10 * std::log10(signal / noise);
+    };
+
+    // Full-scale and weak blocks keep the same precision
+    for (const double amplitude: {0.9, 1e-3})
+    {
+        for (size_t size: {64, 1024})
+        {
+            SCOPED_TRACE(std::format("{} {}", amplitude, size));
+            auto src = test_signal<double>(size);
+            std::vector<fixed::iq16> x(size);
+            for (size_t n = 0; n < size; ++n)
+            {
+                x[n] = fixed::to_iq16(src[n] * (amplitude / 2.5)); // |test_signal| < 2.5
+                src[n] = fixed::to_complex<double>(x[n]);
+            }
+
+            const auto exponent = fft::fft2(std::span(x));
+            ASSERT_TRUE(exponent.has_value());
+            EXPECT_GT(snr(x, *exponent, naive_dft(src)), 55);
+
+            const auto back = fft::ifft2(std::span(x), *exponent);
+            ASSERT_TRUE(back.has_value());
+            EXPECT_GT(snr(x, *back, src), 50);
+        }
+    }
+
+    std::vector<fixed::iq16> odd(12);
+    EXPECT_FALSE(fft::fft2(std::span(odd)).has_value());
+}
+
+TEST(FFTTest, FixedPointVectorStagesMatchScalarExactly)
+{
+    if (!simd::supported(simd::isa::avx2))
+        GTEST_SKIP() << "AVX2 is not supported by the CPU";
+
+    for (size_t size: {16, 32, 256})
+    {
+        SCOPED_TRACE(size);
+        std::vector<fixed::iq16> scalar(size);
+        for (size_t n = 0; n < size; ++n)
+            scalar[n] = fixed::to_iq16(test_signal<double>(size)[n] * 0.3);
+        auto vector = scalar;
+
+        const auto a = fft::q15_plan::create(size, fft::direction::inverse, simd::isa::scalar);
+        const auto b = fft::q15_plan::create(size, fft::direction::inverse, simd::isa::avx2);
+        ASSERT_TRUE(a.has_value() && b.has_value());
+        EXPECT_EQ(a->execute(scalar).value(), b->execute(vector).value());
+        EXPECT_EQ(scalar, vector);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "fir.hpp"
+#include <complex>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace
+{
+    std::vector<std::complex<double>> noise(size_t size, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<double> dist;
+        std::vector<std::complex<double>> out(size);
+        for (auto& v: out)
+            v = { dist(gen), dist(gen) };
+        return out;
+    }
+}
+
+TEST(FirTest, StreamMatchesTheDirectConvolution)
+{
+    for (auto [taps, block]: { std::pair<size_t, size_t>{ 300, 64 }, { 64, 64 }, { 5, 0 }, { 1000, 0 }, { 77, 48 } })
+    {
+        const auto h = noise(taps, 1);
+        const auto x = noise(3000, 2);
+        auto f = filter::fir<double>::create(h, block);
+        ASSERT_TRUE(f.has_value());
+        const size_t delay = f->latency();
+
+        // The chunks of uneven sizes
+        std::vector<std::complex<double>> y(x.size());
+        std::mt19937 gen(3);
+        for (size_t i = 0; i < x.size();)
+        {
+            const size_t n = std::min<size_t>(x.size() - i, gen() % 200);
+            ASSERT_TRUE(f->process(std::span(x).subspan(i, n), std::span(y).subspan(i, n)).has_value());
+            i += n;
+        }
+
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            std::complex<double> expected = 0;
+            for (size_t t = 0; t < taps && t + delay <= n; ++t)
+                expected += h[t] * x[n - delay - t];
+            ASSERT_NEAR(std::abs(y[n] - expected), 0, 1e-9) << taps << " " << n;
+        }
+    }
+}
+
+TEST(FirTest, ResetsAndRejectsMismatchingBuffers)
+{
+    const auto h = noise(40, 4);
+    const auto x = noise(256, 5);
+    auto f = filter::fir<double>::create(h, 32);
+    ASSERT_TRUE(f.has_value());
+
+    std::vector<std::complex<double>> first(x.size()), second(x.size());
+    ASSERT_TRUE(f->process(x, first).has_value());
+    f->reset();
+    ASSERT_TRUE(f->process(x, second).has_value());
+    EXPECT_EQ(first, second);
+
+    EXPECT_FALSE(f->process(x, std::span(second).first(10)).has_value());
+    EXPECT_FALSE(filter::fir<double>::create(std::span<const std::complex<double>>{}).has_value());
+}
\ No newline at end of file
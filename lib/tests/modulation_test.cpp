@@ -0,0 +1,204 @@
+#include "modulation.hpp"
+#include <bit>
+#include <array>
+#include <complex>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+template <typename Mod>
+class ModulationTest : public ::testing::Test {};
+
+using Modulations = ::testing::Types<modulation::eBPSK, modulation::eQPSK, modulation::e16QAM,
+                                     modulation::e64QAM, modulation::e256QAM, modulation::e1024QAM>;
+TYPED_TEST_SUITE(ModulationTest, Modulations);
+
+TYPED_TEST(ModulationTest, TableIsGrayCodedWithUnitPower)
+{
+    using Mod = TypeParam;
+    const auto& table = Mod::template table<double>;
+    ASSERT_EQ(table.size(), size_t{1} << Mod::bits_per_symbol);
+
+    double power = 0;
+    for (size_t s = 0; s < table.size(); ++s)
+    {
+        power += std::norm(table[s] * Mod::template norm<double>);
+        for (size_t t = 0; t < table.size(); ++t)
+        {
+            if (std::abs(std::abs(table[s] - table[t]) - 2) < 1e-12) // The nearest neighbours
+            {
+                EXPECT_EQ(std::popcount(s ^ t), 1) << s << " " << t;
+            }
+        }
+    }
+    EXPECT_NEAR(power / table.size(), 1, 1e-12);
+}
+
+TYPED_TEST(ModulationTest, SlicesNoisyPointsToTheNearest)
+{
+    using Mod = TypeParam;
+    const auto& table = Mod::template table<double>;
+    const double unit = Mod::template norm<double>;
+    for (uint32_t s = 0; s < table.size(); ++s)
+    {
+        const auto pt = table[s] * unit;
+        EXPECT_EQ(Mod::nearest(pt), s);
+        EXPECT_EQ(Mod::nearest(pt + std::complex<double>(0.9 * unit, -0.9 * unit)), s); // Within the decision region
+    }
+
+    size_t corner = 0; // The farthest point of the fourth quadrant
+    for (size_t s = 0; s < table.size(); ++s)
+        if (table[s].real() - table[s].imag() > table[corner].real() - table[corner].imag())
+            corner = s;
+    EXPECT_EQ(Mod::nearest(std::complex<double>(100, -100)), corner); // Beyond the outermost levels
+}
+
+TYPED_TEST(ModulationTest, MapsBytesForthAndBack)
+{
+    using Mod = TypeParam;
+    std::vector<uint8_t> in{'H', 'e', 'l', 'l', 'o', ',', ' ', 'Q', 'A', 'M', '!', 0x00, 0xFF, 0xA5, 0x5A};
+
+    const auto symbols = modulation::to_constl<Mod>(in);
+    EXPECT_EQ(symbols.size(), modulation::symbols<Mod>(in.size()));
+    EXPECT_EQ(modulation::from_constl<Mod>(symbols), in);
+
+    utils::split_buffer<float> split;
+    modulation::to_constl<Mod>(in, split);
+    EXPECT_EQ(modulation::from_constl<Mod>(split), in);
+
+    std::vector<fixed::iq16> q15;
+    const int exponent = modulation::to_constl<Mod>(in, q15);
+    EXPECT_EQ(modulation::from_constl<Mod>(q15, exponent), in);
+    for (auto& v: q15)
+        v = { static_cast<int16_t>(v.re / 4), static_cast<int16_t>(v.im / 4) };
+    EXPECT_EQ(modulation::from_constl<Mod>(q15, exponent + 2), in); // The same points of a larger block exponent
+}
+
+TYPED_TEST(ModulationTest, MapsIntoCallerBuffers)
+{
+    using Mod = TypeParam;
+    const std::array<uint8_t, 15> in{'N', 'o', ' ', 'a', 'l', 'l', 'o', 'c', 's', '!', 0x00, 0xFF, 0xA5, 0x5A, 0x3C};
+    const size_t count = modulation::symbols<Mod>(in.size());
+
+    std::vector<std::complex<float>> symbols(count + 3);
+    EXPECT_EQ(modulation::to_constl<Mod>(in, std::span(symbols)).value(), count);
+    EXPECT_FALSE(modulation::to_constl<Mod>(in, std::span(symbols).first(count - 1)).has_value());
+
+    std::vector<std::complex<float>> appended;
+    EXPECT_EQ((modulation::to_constl<Mod, float>(in, std::back_inserter(appended))), count);
+    EXPECT_TRUE(std::equal(appended.begin(), appended.end(), symbols.begin()));
+
+    std::array<uint8_t, in.size() + 1> bytes{};
+    const auto received = std::span(symbols).first(count);
+    EXPECT_EQ((modulation::from_constl<Mod, float>(received, std::span(bytes)).value()), in.size());
+    EXPECT_TRUE(std::equal(in.begin(), in.end(), bytes.begin()));
+    EXPECT_FALSE((modulation::from_constl<Mod, float>(received, std::span(bytes).first(in.size() - 1)).has_value()));
+
+    std::vector<uint8_t> streamed;
+    EXPECT_EQ((modulation::from_constl<Mod, float>(received, std::back_inserter(streamed))), in.size());
+    EXPECT_TRUE(std::equal(in.begin(), in.end(), streamed.begin(), streamed.end()));
+}
+
+TYPED_TEST(ModulationTest, VectorDecisionsMatchNearest)
+{
+    using Mod = TypeParam;
+    const auto check = [](auto zero)
+    {
+        using T = decltype(zero);
+        const T unit = Mod::template norm<T>;
+        const T edge = Mod::template table<T>[0].real() * unit;
+        std::mt19937 gen(7);
+        std::normal_distribution<T> noise(0, 3 * unit);
+        std::uniform_int_distribution<size_t> pick(0, Mod::template table<T>.size() - 1);
+
+        std::vector<std::complex<T>> in;
+        for (size_t n = 0; n < 1000; ++n)
+            in.push_back(Mod::template table<T>[pick(gen)] * unit + std::complex<T>(noise(gen), noise(gen)));
+        for (int k = -2; k <= 2 * static_cast<int>(-edge / unit) + 2; ++k) // On the decision boundaries and beyond
+            in.push_back({ edge + (2 * k - 1) * unit, edge - (2 * k - 1) * unit });
+        in.push_back({ -T{0}, T{0} });
+        in.resize(in.size() + 13); // Not a multiple of the vector steps
+
+        std::vector<uint8_t> expected(in.size() * Mod::bits_per_symbol / 8);
+        utils::bit_writer writer(expected.data());
+        for (const auto& pt: in)
+            writer.write(Mod::nearest(pt), Mod::bits_per_symbol);
+        writer.flush();
+
+        for (auto set: { simd::isa::scalar, simd::isa::avx2, simd::isa::avx512 })
+        {
+            if (!simd::supported(set))
+                continue;
+            std::vector<uint8_t> out(expected.size());
+            modulation::detail::demap<Mod>(in.data(), in.size(), out.data(), set);
+            EXPECT_EQ(out, expected) << simd::name(set) << " " << sizeof(T);
+        }
+    };
+    check(float{});
+    check(double{});
+}
+
+TYPED_TEST(ModulationTest, SoftDecisionsAreTheMaxLogRatios)
+{
+    using Mod = TypeParam;
+    const auto check = [](auto zero)
+    {
+        using T = decltype(zero);
+        constexpr size_t bits = Mod::bits_per_symbol;
+        const auto& table = Mod::template table<T>;
+        const T unit = Mod::template norm<T>;
+        const T noise_variance = T{0.05};
+        std::mt19937 gen(11);
+        std::normal_distribution<T> noise(0, 2 * unit);
+        std::uniform_int_distribution<size_t> pick(0, table.size() - 1);
+
+        std::vector<std::complex<T>> in;
+        for (size_t n = 0; n < 203; ++n)
+            in.push_back(table[pick(gen)] * unit + std::complex<T>(noise(gen), noise(gen)));
+
+        // The brute force: the nearest points of either value of every bit
+        std::vector<T> expected;
+        for (const auto& y: in)
+        {
+            for (size_t k = 0; k < bits; ++k)
+            {
+                T d[2] = { std::numeric_limits<T>::max(), std::numeric_limits<T>::max() };
+                for (size_t s = 0; s < table.size(); ++s)
+                {
+                    auto& nearest = d[(s >> (bits - 1 - k)) & 1];
+                    nearest = std::min(nearest, std::norm(y - table[s] * unit));
+                }
+                expected.push_back((d[1] - d[0]) / noise_variance);
+            }
+        }
+
+        std::vector<T> llr;
+        ASSERT_TRUE(modulation::to_llr<Mod>(in, noise_variance, llr).has_value());
+        ASSERT_EQ(llr.size(), expected.size());
+        for (auto set: { simd::isa::scalar, simd::isa::avx2, simd::isa::avx512 })
+        {
+            if (!simd::supported(set))
+                continue;
+            std::vector<T> out(expected.size());
+            std::vector<int8_t> quantized(expected.size());
+            modulation::detail::llr<Mod>(in.data(), in.size(), out.data(), noise_variance, T{1}, set);
+            modulation::detail::llr<Mod>(in.data(), in.size(), quantized.data(), noise_variance, T{4}, set);
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                EXPECT_NEAR(out[i], expected[i], 1e-3 * (1 + std::abs(expected[i]))) << simd::name(set) << " " << i;
+                EXPECT_NEAR(quantized[i], std::clamp<T>(4 * expected[i], -127, 127), 1) << simd::name(set) << " " << i;
+            }
+        }
+
+        std::vector<int8_t> quantized;
+        EXPECT_FALSE(modulation::to_llr<Mod>(in, T{0}, llr).has_value());
+        EXPECT_FALSE(modulation::to_llr<Mod>(in, -noise_variance, llr).has_value());
+        EXPECT_FALSE(modulation::to_llr<Mod>(in, std::numeric_limits<T>::quiet_NaN(), llr).has_value());
+        EXPECT_FALSE(modulation::to_llr<Mod>(in, T{0}, quantized, T{4}).has_value());
+        EXPECT_FALSE(modulation::to_llr<Mod>(in, noise_variance, quantized, T{0}).has_value());
+    };
+    check(float{});
+    check(double{});
+}
\ No newline at end of file
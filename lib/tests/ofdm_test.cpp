@@ -1,10 +1,18 @@
 #include "modulation.hpp"
+#include "equalizer.hpp"
 #include "ofdm.hpp"
+#include "pipeline.hpp"
+#include "synchronizer.hpp"
 #include <vector>
 #include <complex>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <thread>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+using ::testing::ElementsAre;
 using ::testing::Pointwise;
 using ::testing::Truly;
 
@@ -34,3 +42,422 @@ TEST(OFDMTest, Transforms16QAMForthAndBackCorrectly)
 
     EXPECT_EQ(res, in);
 }
+
+
+TEST(OFDMTest, TransformsSplitLayoutForthAndBackCorrectly)
+{
+    std::vector<uint8_t> in{'H', 'e', 'l', 'l', 'o', ',', ' ', 'O', 'F', 'D', 'M', '!', ' ', 'S', 'o', 'A'};
+
+    utils::split_buffer<float> symbols, buf, res;
+    modulation::to_constl<modulation::e16QAM>(in, symbols);
+    ASSERT_TRUE(ofdm::tx(symbols, 8, buf).has_value());
+    ASSERT_TRUE(ofdm::rx(buf, 8, res).has_value());
+
+    EXPECT_EQ(buf[0], buf[buf.size() - 8]);
+    EXPECT_EQ(modulation::from_constl<modulation::e16QAM>(res), in);
+}
+
+TEST(OFDMTest, FusedTransmitterMatchesMappingThenTransmitting)
+{
+    // Radix-2, codelet, mixed-radix and Bluestein sizes of the symbol
+    for (const size_t bytes: {4, 8, 32, 6, 7})
+    {
+        SCOPED_TRACE(bytes);
+        std::vector<uint8_t> in(bytes);
+        for (size_t i = 0; i < bytes; ++i)
+            in[i] = static_cast<uint8_t>(37 * i + 11);
+
+        std::vector<std::complex<double>> ref, fused;
+        ASSERT_TRUE(ofdm::tx(modulation::to_constl<modulation::e16QAM>(in), 4, ref).has_value());
+        ASSERT_TRUE(ofdm::tx<modulation::e16QAM>(in, 4, fused).has_value());
+
+        EXPECT_THAT(fused, Pointwise(Truly([](const auto& pair)
+        {
+            const auto& [a, b] = pair;
+            return std::abs(a - b) < 1e-12;
+        }), ref));
+
+        std::vector<std::complex<double>> res;
+        ASSERT_TRUE(ofdm::rx(fused, 4, res).has_value());
+        EXPECT_EQ(modulation::from_constl<modulation::e16QAM>(res), in);
+    }
+
+    std::vector<std::complex<float>> out;
+    EXPECT_FALSE(ofdm::tx<modulation::e16QAM>(std::vector<uint8_t>{1, 2}, 5, out).has_value());
+}
+
+TEST(OFDMTest, FixedPointTransmitsForthAndBackCorrectly)
+{
+    std::vector<uint8_t> in{'H', 'e', 'l', 'l', 'o', ',', ' ', 'O', 'F', 'D', 'M', '!', ' ', 'S', 'o', 'A'};
+
+    std::vector<fixed::iq16> buf, res;
+    const auto tx_exponent = ofdm::tx<modulation::e16QAM>(in, 8, buf);
+    ASSERT_TRUE(tx_exponent.has_value());
+    EXPECT_EQ(buf.size(), 40u);
+    EXPECT_EQ(buf[0], buf[buf.size() - 8]);
+
+    const auto rx_exponent = ofdm::rx(buf, 8, res, *tx_exponent);
+    ASSERT_TRUE(rx_exponent.has_value());
+    EXPECT_EQ(modulation::from_constl<modulation::e16QAM>(res, *rx_exponent), in);
+
+    // The same bits through the Q15 mapper alone
+    std::vector<fixed::iq16> symbols;
+    modulation::to_constl<modulation::e16QAM>(in, symbols);
+    EXPECT_EQ(modulation::from_constl<modulation::e16QAM>(symbols, 0), in);
+}
+
+TEST(OFDMTest, FrameModulatorMatchesSymbolBySymbol)
+{
+    constexpr size_t N = 16, cp = 4, K = 5;
+    std::mt19937 gen(5);
+    std::normal_distribution<double> noise;
+    std::vector<std::complex<double>> in(K * N);
+    for (auto& v: in)
+        v = { noise(gen), noise(gen) };
+
+    auto mod = ofdm::modulator<double>::create(N, cp);
+    auto demod = ofdm::demodulator<double>::create(N, cp);
+    ASSERT_TRUE(mod.has_value());
+    ASSERT_TRUE(demod.has_value());
+
+    const auto frame = mod->process(in);
+    ASSERT_TRUE(frame.has_value());
+    ASSERT_EQ(frame->size(), K * (N + cp));
+    for (size_t k = 0; k < K; ++k)
+    {
+        std::vector<std::complex<double>> symbol;
+        ASSERT_TRUE(ofdm::tx(std::vector(in.begin() + k * N, in.begin() + (k + 1) * N), cp, symbol).has_value());
+        for (size_t n = 0; n < N + cp; ++n)
+            EXPECT_NEAR(std::abs((*frame)[k * (N + cp) + n] - symbol[n]), 0, 1e-12) << k << " " << n;
+    }
+
+    const auto out = demod->process(*frame);
+    ASSERT_TRUE(out.has_value());
+    ASSERT_EQ(out->size(), in.size());
+    for (size_t i = 0; i < in.size(); ++i)
+        EXPECT_NEAR(std::abs((*out)[i] - in[i]), 0, 1e-12) << i;
+
+    // The buffers are reused by the frames of the same size
+    EXPECT_EQ(mod->process(in)->data(), frame->data());
+    EXPECT_EQ(demod->process(*frame)->data(), out->data());
+
+    EXPECT_FALSE(mod->process(std::span(in).first(N + 1)).has_value());
+    EXPECT_FALSE(demod->process(frame->first(N)).has_value());
+    EXPECT_FALSE(ofdm::modulator<double>::create(N, N + 1).has_value());
+}
+
+TEST(OFDMTest, FrameModulatorTransmitsBytesForthAndBack)
+{
+    const std::vector<uint8_t> in{'H', 'e', 'l', 'l', 'o', ',', ' ', 'f', 'r', 'a', 'm', 'e', 's', '!'};
+
+    auto mod = ofdm::modulator<float>::create(12, 3);     // 19 64-QAM symbols padded to 2 of 12 subcarriers
+    auto demod = ofdm::demodulator<float>::create(12, 3);
+    ASSERT_TRUE(mod.has_value());
+    ASSERT_TRUE(demod.has_value());
+
+    const auto frame = mod->transmit<modulation::e64QAM>(in);
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_EQ(frame->size(), 2u * 15);
+
+    const auto out = demod->receive<modulation::e64QAM>(*frame);
+    ASSERT_TRUE(out.has_value());
+    ASSERT_EQ(out->size(), 18u);
+    EXPECT_TRUE(std::equal(in.begin(), in.end(), out->begin()));
+}
+
+TEST(OFDMTest, TransformsInPlaceOverSpans)
+{
+    constexpr size_t N = 64, cp = 16;
+    std::mt19937 gen(19);
+    std::normal_distribution<double> noise;
+    std::vector<std::complex<double>> in(N);
+    for (auto& v: in)
+        v = { noise(gen), noise(gen) };
+
+    std::vector<std::complex<double>> expected;
+    ASSERT_TRUE(ofdm::tx(in, cp, expected).has_value());
+
+    std::vector<std::complex<double>> symbol(N + cp);
+    std::copy(in.begin(), in.end(), symbol.begin() + cp);
+    ASSERT_TRUE(ofdm::tx(std::span(symbol), cp).has_value());
+    for (size_t n = 0; n < N + cp; ++n)
+        EXPECT_NEAR(std::abs(symbol[n] - expected[n]), 0, 1e-12) << n;
+
+    const auto out = ofdm::rx(std::span(symbol), cp);
+    ASSERT_TRUE(out.has_value());
+    EXPECT_EQ(out->data(), symbol.data() + cp);
+    ASSERT_EQ(out->size(), N);
+    for (size_t n = 0; n < N; ++n)
+        EXPECT_NEAR(std::abs((*out)[n] - in[n]), 0, 1e-12) << n;
+
+    EXPECT_FALSE(ofdm::tx(std::span(symbol).first(2 * cp - 1), cp).has_value());
+    EXPECT_FALSE(ofdm::rx(std::span(symbol).first(cp - 1), cp).has_value());
+}
+
+TEST(OFDMTest, MapsSubcarriersOfIEEE80211a)
+{
+    const auto map = ofdm::subcarrier_map::ieee80211a();
+    ASSERT_EQ(map.size(), 64u);
+    ASSERT_EQ(map.data_size(), 48u);
+    ASSERT_EQ(map.pilot_size(), 4u);
+    EXPECT_THAT(map.pilot_bins(), ElementsAre(64 - 21, 64 - 7, 7, 21));
+    EXPECT_EQ(map.data_bins().front(), 64u - 26);
+    EXPECT_EQ(map.data_bins().back(), 26u);
+
+    constexpr size_t cp = 16;
+    std::mt19937 gen(20);
+    std::normal_distribution<double> noise;
+    std::vector<std::complex<double>> data(map.data_size());
+    for (auto& v: data)
+        v = { noise(gen), noise(gen) };
+
+    std::vector<std::complex<double>> symbol(map.size() + cp);
+    ASSERT_TRUE(ofdm::tx(map, std::span<const std::complex<double>>(data), cp, std::span(symbol), -1).has_value());
+
+    std::vector<std::complex<double>> bins(symbol.begin() + cp, symbol.end());
+    ASSERT_TRUE(ofdm::rx(std::span(bins), 0).has_value());
+    for (size_t k = 0; k < 64; ++k)
+    {
+        if ((k >= 27 && k <= 37) || k == 0)
+        {
+            EXPECT_NEAR(std::abs(bins[k]), 0, 1e-12) << k;   // the guard bands and the DC
+        }
+    }
+    EXPECT_NEAR(std::abs(bins[21] - 1.0), 0, 1e-12);        // the last pilot -1 of the negative polarity
+
+    std::vector<std::complex<double>> out(map.data_size()), pilots(map.pilot_size());
+    ASSERT_TRUE(ofdm::rx(map, std::span(symbol), cp, std::span(out)).has_value());
+    for (size_t i = 0; i < data.size(); ++i)
+        EXPECT_NEAR(std::abs(out[i] - data[i]), 0, 1e-12) << i;
+    ASSERT_TRUE(map.extract_pilots(std::span<const std::complex<double>>(symbol).subspan(cp), std::span(pilots)).has_value());
+    EXPECT_NEAR(std::abs(pilots[0] + 1.0), 0, 1e-12);
+
+    EXPECT_FALSE(ofdm::tx(map, std::span<const std::complex<double>>(data).first(47), cp, std::span(symbol)).has_value());
+    const ofdm::subcarrier allocation[] = { ofdm::subcarrier::pilot, ofdm::subcarrier::data };
+    EXPECT_FALSE(ofdm::subcarrier_map::create(allocation, {}).has_value());
+}
+
+TEST(OFDMTest, SynchronizerFindsThePreambleAndItsFrequencyOffset)
+{
+    constexpr size_t L = 32, cp = 16, start = 1000;
+    constexpr double offset = 0.004;    // cycles per sample, within 1 / (2 * L)
+    std::mt19937 gen(21);
+    std::normal_distribution<double> noise;
+
+    // Noise, then the cyclic prefix and the two identical halves, then noise again, all shifted by the CFO
+    std::vector<std::complex<double>> half(L), stream;
+    for (auto& v: half)
+        v = { noise(gen), noise(gen) };
+    for (size_t n = 0; n < start - cp; ++n)
+        stream.push_back({ 0.05 * noise(gen), 0.05 * noise(gen) });
+    stream.insert(stream.end(), half.end() - cp, half.end());
+    stream.insert(stream.end(), half.begin(), half.end());
+    stream.insert(stream.end(), half.begin(), half.end());
+    for (size_t n = 0; n < 3000; ++n)
+        stream.push_back({ 0.05 * noise(gen), 0.05 * noise(gen) });
+    for (size_t n = 0; n < stream.size(); ++n)
+        stream[n] *= std::polar(1.0, 2 * std::numbers::pi * offset * n);
+
+    auto sync = ofdm::synchronizer<double>::create(L, L);
+    ASSERT_TRUE(sync.has_value());
+    std::vector<ofdm::detection<double>> found;
+    for (size_t n = 0; n < stream.size(); n += 100)    // the stream in chunks
+        sync->process(std::span(stream).subspan(n, std::min<size_t>(100, stream.size() - n)), [&found](const ofdm::detection<double>& d)
+        {
+            found.push_back(d);
+        });
+
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_GE(found[0].index, start - cp);  // anywhere on the plateau of the prefix
+    EXPECT_LE(found[0].index, start);
+    EXPECT_GT(found[0].metric, 0.9);
+    EXPECT_NEAR(found[0].cfo, offset, 1e-4);
+    EXPECT_EQ(sync->position(), stream.size());
+
+    EXPECT_FALSE(ofdm::synchronizer<double>::create(0, L).has_value());
+    EXPECT_FALSE(ofdm::synchronizer<double>::create(L, L, 1.5).has_value());
+}
+
+TEST(OFDMTest, EqualizesTheChannelOfThePilots)
+{
+    const auto map = ofdm::subcarrier_map::ieee80211a();
+    constexpr size_t cp = 16;
+    std::mt19937 gen(22);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> in(map.data_size() / 2);    // a 16-QAM symbol
+    for (auto& v: in)
+        v = static_cast<uint8_t>(byte(gen));
+    const auto data = modulation::to_constl<modulation::e16QAM>(in);
+
+    // The multipath shorter than the cyclic prefix: a circular convolution of the symbol
+    const auto receive = [&](const std::vector<std::complex<double>>& taps)
+    {
+        std::vector<std::complex<double>> symbol(map.size() + cp), bins(map.size()), out(map.data_size());
+        EXPECT_TRUE(ofdm::tx(map, std::span<const std::complex<double>>(data), cp, std::span(symbol), -1).has_value());
+        std::vector<std::complex<double>> received(symbol.size());
+        for (size_t n = taps.size(); n < symbol.size(); ++n)
+            for (size_t t = 0; t < taps.size(); ++t)
+                received[n] += taps[t] * symbol[n - t];
+        EXPECT_TRUE(ofdm::rx(map, std::span(received), cp, std::span(out)).has_value());
+        std::copy(received.begin() + cp, received.end(), bins.begin());
+        return std::pair(bins, out);
+    };
+
+    auto channel = ofdm::channel_estimator<double>::create(map);
+    ASSERT_TRUE(channel.has_value());
+    for (auto set: { simd::isa::scalar, simd::isa::avx2, simd::isa::avx512 })
+    {
+        if (!simd::supported(set))
+            continue;
+        auto zf = ofdm::equalizer<double>::create(0, set);
+        ASSERT_TRUE(zf.has_value());
+
+        // A flat channel is estimated exactly
+        auto [bins, out] = receive({ std::polar(0.5, 1.0) });
+        ASSERT_TRUE(channel->update(std::span<const std::complex<double>>(bins), -1).has_value());
+        ASSERT_TRUE(zf->apply(*channel, std::span(out)).has_value());
+        for (size_t i = 0; i < data.size(); ++i)
+            EXPECT_NEAR(std::abs(out[i] - data[i]), 0, 1e-12) << simd::name(set) << " " << i;
+
+        // The rotation and the mild multipath break the decisions unless equalized
+        std::tie(bins, out) = receive({ { 0, 0.9 }, { 0.15, -0.1 } });
+        EXPECT_NE(modulation::from_constl<modulation::e16QAM>(out), in);
+        ASSERT_TRUE(channel->update(std::span<const std::complex<double>>(bins), -1).has_value());
+        ASSERT_TRUE(zf->apply(*channel, std::span(out)).has_value());
+        EXPECT_EQ(modulation::from_constl<modulation::e16QAM>(out), in) << simd::name(set);
+    }
+
+    EXPECT_FALSE(ofdm::equalizer<double>::create(-1).has_value());
+    EXPECT_FALSE(ofdm::channel_estimator<double>::create(map, 0).has_value());
+}
+
+TEST(OFDMTest, EqualizerFollowsTheEstimate)
+{
+    const auto map = ofdm::subcarrier_map::ieee80211a();
+    constexpr size_t cp = 16;
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> in(map.data_size() / 2);
+    for (auto& v: in)
+        v = static_cast<uint8_t>(byte(gen));
+    const auto data = modulation::to_constl<modulation::e16QAM>(in);
+
+    // A symbol through the flat channel h: the bins for the estimate and the data subcarriers
+    const auto receive = [&](std::complex<double> h)
+    {
+        std::vector<std::complex<double>> symbol(map.size() + cp), bins(map.size()), out(map.data_size());
+        EXPECT_TRUE(ofdm::tx(map, std::span<const std::complex<double>>(data), cp, std::span(symbol)).has_value());
+        for (auto& v: symbol)
+            v *= h;
+        EXPECT_TRUE(ofdm::rx(map, std::span(symbol), cp, std::span(out)).has_value());
+        std::copy(symbol.begin() + cp, symbol.end(), bins.begin());
+        return std::pair(bins, out);
+    };
+    const std::complex<double> h1 = std::polar(0.5, 1.0), h2 = std::polar(1.5, -2.0);
+
+    // MMSE: conj(H) / (|H|^2 + N0) shrinks the symbols by |H|^2 / (|H|^2 + N0)
+    auto channel = ofdm::channel_estimator<double>::create(map);
+    auto mmse = ofdm::equalizer<double>::create(0.1);
+    ASSERT_TRUE(channel.has_value());
+    ASSERT_TRUE(mmse.has_value());
+    auto [bins, out] = receive(h1);
+    ASSERT_TRUE(channel->update(std::span<const std::complex<double>>(bins)).has_value());
+    ASSERT_TRUE(mmse->apply(*channel, std::span(out)).has_value());
+    for (size_t i = 0; i < data.size(); ++i)
+        EXPECT_NEAR(std::abs(out[i] - data[i] * (0.25 / 0.35)), 0, 1e-12) << i;
+
+    // The new noise variance reaches the weights of the same estimate
+    ASSERT_TRUE(mmse->set_noise_variance(0).has_value());
+    std::tie(bins, out) = receive(h1);
+    ASSERT_TRUE(mmse->apply(*channel, std::span(out)).has_value());
+    for (size_t i = 0; i < data.size(); ++i)
+        EXPECT_NEAR(std::abs(out[i] - data[i]), 0, 1e-12) << i;
+
+    // An estimator replaced at the same address and updated as often is not mistaken for the old one
+    channel = ofdm::channel_estimator<double>::create(map);
+    ASSERT_TRUE(channel.has_value());
+    std::tie(bins, out) = receive(h2);
+    ASSERT_TRUE(channel->update(std::span<const std::complex<double>>(bins)).has_value());
+    ASSERT_TRUE(mmse->apply(*channel, std::span(out)).has_value());
+    for (size_t i = 0; i < data.size(); ++i)
+        EXPECT_NEAR(std::abs(out[i] - data[i]), 0, 1e-12) << i;
+
+    // The smoothing averages the symbols after the first one
+    auto smoothed = ofdm::channel_estimator<double>::create(map, 0.25);
+    ASSERT_TRUE(smoothed.has_value());
+    std::tie(bins, out) = receive(h1);
+    ASSERT_TRUE(smoothed->update(std::span<const std::complex<double>>(bins)).has_value());
+    for (const auto& H: smoothed->estimate())
+        EXPECT_NEAR(std::abs(H - h1), 0, 1e-12);
+    std::tie(bins, out) = receive(h2);
+    ASSERT_TRUE(smoothed->update(std::span<const std::complex<double>>(bins)).has_value());
+    for (const auto& H: smoothed->estimate())
+        EXPECT_NEAR(std::abs(H - (0.75 * h1 + 0.25 * h2)), 0, 1e-12);
+
+    EXPECT_FALSE(mmse->set_noise_variance(-1).has_value());
+    EXPECT_FALSE(mmse->set_noise_variance(std::numeric_limits<double>::quiet_NaN()).has_value());
+    EXPECT_FALSE(smoothed->update(std::span<const std::complex<double>>(bins), 0).has_value());
+}
+
+TEST(OFDMTest, ReceiveChainRunsAsAPipeline)
+{
+    constexpr size_t N = 64, cp = 16, K = 4;
+    struct frame
+    {
+        std::vector<std::complex<float>>    samples{};
+        std::vector<std::complex<float>>    subcarriers{};
+        std::vector<uint8_t>                bytes{};
+        std::string                         error{};    // the failure of a stage, the later ones passing the frame on
+    };
+
+    auto mod = ofdm::modulator<float>::create(N, cp);
+    auto demod = ofdm::demodulator<float>::create(N, cp);
+    ASSERT_TRUE(mod.has_value());
+    ASSERT_TRUE(demod.has_value());
+
+    // Every stage owns its state, the frames carry the data from one stage to the next
+    auto chain = parallel::pipeline<frame>::create({
+        { "fft", [&demod](frame& f)
+        {
+            const auto out = demod->process(f.samples);
+            if (!out.has_value())
+                f.error = out.error();
+            else
+                f.subcarriers.assign(out->begin(), out->end());
+        } },
+        { "demap", [](frame& f)
+        {
+            if (f.error.empty())
+                f.bytes = modulation::from_constl<modulation::e16QAM, float>(f.subcarriers);
+        } } });
+    ASSERT_TRUE(chain.has_value());
+
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::vector<uint8_t>> sent;
+    std::thread producer([&]()
+    {
+        for (size_t i = 0; i < 50; ++i)
+        {
+            auto& in = sent.emplace_back(K * N / 2);
+            for (auto& v: in)
+                v = static_cast<uint8_t>(byte(gen));
+            const auto samples = mod->transmit<modulation::e16QAM>(in);
+            EXPECT_TRUE(samples.has_value());
+            if (!samples.has_value())
+                break;
+            chain->push({ .samples = { samples->begin(), samples->end() } });
+        }
+        chain->close();
+    });
+
+    std::vector<std::vector<uint8_t>> received;
+    while (auto f = chain->pop())
+    {
+        EXPECT_EQ(f->error, "");
+        received.push_back(std::move(f->bytes));
+    }
+    producer.join();
+    EXPECT_EQ(received, sent);
+    EXPECT_EQ(chain->stats()[0].batches, 50u);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "parallel.hpp"
+#include "pipeline.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+TEST(Parallel, ForRangeCoversEveryIndexOnce)
+{
+    for (size_t count: {0, 1, 7, 1000, 100000})
+    {
+        std::vector<std::atomic<int>> hits(count);
+        parallel::for_range(count, 10, [&hits](size_t first, size_t last)
+        {
+            for (size_t i = first; i != last; ++i)
+                ++hits[i];
+        });
+        for (size_t i = 0; i < count; ++i)
+            ASSERT_EQ(hits[i], 1) << i;
+    }
+}
+
+TEST(Parallel, NestedForRangeRunsInline)
+{
+    std::atomic<size_t> total = 0;
+    parallel::for_range(64, 1, [&total](size_t first, size_t last)
+    {
+        for (size_t i = first; i != last; ++i)
+            parallel::for_range(100, 1, [&total](size_t a, size_t b) { total += b - a; });
+    });
+    EXPECT_EQ(total, 6400u);
+}
+
+TEST(Parallel, QueuePassesItemsInOrderUnderBackpressure)
+{
+    parallel::spsc_queue<size_t> queue(4);
+    // The outcomes are checked after the join: an early return would leave the other side waiting
+    size_t pushed = 0;
+    std::thread producer([&queue, &pushed]()
+    {
+        for (size_t i = 0; i < 100000; ++i)
+            pushed += queue.push(size_t{i});
+        queue.close();
+    });
+
+    size_t expected = 0, disordered = 0;
+    while (auto item = queue.pop())
+        disordered += *item != expected++;
+    producer.join();
+    EXPECT_EQ(pushed, 100000u);
+    EXPECT_EQ(expected, 100000u);
+    EXPECT_EQ(disordered, 0u);
+
+    queue.abandon();
+    size_t dropped = 0;
+    while (queue.push(0))
+        ASSERT_LE(++dropped, queue.capacity());
+}
+
+TEST(Parallel, PipelineRunsTheStagesInOrder)
+{
+    using batch = std::vector<int>;
+    auto p = parallel::pipeline<batch>::create({
+        { "add", [](batch& b) { for (auto& v: b) v += 1; } },
+        { "multiply", [](batch& b) { for (auto& v: b) v *= 2; } },
+        { "subtract", [](batch& b) { for (auto& v: b) v -= 3; } } }, 2);
+    ASSERT_TRUE(p.has_value());
+
+    constexpr int batches = 1000;
+    int pushed = 0;
+    std::thread producer([&p, &pushed]()
+    {
+        for (int i = 0; i < batches; ++i)
+            pushed += p->push(batch(16, i));
+        p->close();
+    });
+
+    int expected = 0, wrong = 0;
+    while (auto b = p->pop())
+    {
+        wrong += b->size() != 16u || b->front() != (expected + 1) * 2 - 3;
+        ++expected;
+    }
+    producer.join();
+    EXPECT_EQ(pushed, batches);
+    EXPECT_EQ(expected, batches);
+    EXPECT_EQ(wrong, 0);
+
+    const auto stats = p->stats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[1].name, "multiply");
+    for (const auto& s: stats)
+        EXPECT_EQ(s.batches, static_cast<uint64_t>(batches)) << s.name;
+
+    // Stops with the batches left in flight
+    auto idle = parallel::pipeline<batch>::create({ { "copy", [](batch&) {} } }, 2);
+    ASSERT_TRUE(idle.has_value());
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(idle->push(batch(1, i)));
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "split_buffer.hpp"
+#include <cstdint>
+#include <complex>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using utils::split_buffer;
+
+TEST(SplitBuffer, ArraysAreAlignedToCacheLine)
+{
+    split_buffer<float> b(37);
+    EXPECT_EQ(b.size(), 37u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b.real().data()) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b.imag().data()) % 64, 0u);
+}
+
+TEST(SplitBuffer, ConvertsFromAndToInterleaved)
+{
+    const std::vector<std::complex<double>> ref{{1, 2}, {3, 4}, {-5, 6}};
+    split_buffer<double> b(ref);
+
+    EXPECT_THAT(b.real(), ::testing::ElementsAre(1, 3, -5));
+    EXPECT_THAT(b.imag(), ::testing::ElementsAre(2, 4, 6));
+    EXPECT_EQ(b[2], std::complex<double>(-5, 6));
+
+    b.set(1, {7, 8});
+    EXPECT_EQ(b.to_interleaved(), (std::vector<std::complex<double>>{{1, 2}, {7, 8}, {-5, 6}}));
+}
\ No newline at end of file